@@ -0,0 +1,107 @@
+// Compares a 5-point stencil over a row-major array with the same stencil
+// over HilbertLayout storage. Usage: layout_benchmark [size] [iterations]
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include "hilbertlayout.h"
+
+namespace
+{
+typedef std::chrono::steady_clock Clock;
+
+double rowMajorStencil(std::vector<double> &input, std::vector<double> &output, hsize n, int iterations)
+{
+    Clock::time_point start = Clock::now ();
+    for(int it = 0; it < iterations; ++it)
+    {
+        for(hsize y = 1; y + 1 < n; ++y)
+        {
+            const double *row = input.data () + std::size_t(y) * n;
+            const double *up = row - n;
+            const double *down = row + n;
+            double *out = output.data () + std::size_t(y) * n;
+            for(hsize x = 1; x + 1 < n; ++x)
+                out[x] = 0.2 * (row[x] + row[x - 1] + row[x + 1] + up[x] + down[x]);
+        }
+        input.swap (output);
+    }
+    return std::chrono::duration<double>(Clock::now () - start).count ();
+}
+
+double layoutStencil(const HilbertLayout &layout, std::vector<double> &input, std::vector<double> &output,
+                     int iterations)
+{
+    hsize n = layout.width ();
+    hsize tile = layout.tile ();
+    Clock::time_point start = Clock::now ();
+    for(int it = 0; it < iterations; ++it)
+    {
+        const double *in = input.data ();
+        for(std::size_t t = 0; t < layout.tileCount (); ++t)
+        {
+            hsize x0 = layout.tileOrigin (t).first, y0 = layout.tileOrigin (t).second;
+            hsize first = x0 == 0 ? 1 : 0;
+            hsize last = std::min(tile, n - 1 - x0);
+            for(hsize ly = 0; ly < tile; ++ly)
+            {
+                hsize y = y0 + ly;
+                if(y == 0 || y + 1 >= n)
+                    continue;
+                // Rows above and below are in this tile or at the same
+                // column of the neighbour tile.
+                std::size_t c = layout.tileOffset (t) + ly * tile;
+                const double *row = in + c;
+                const double *up = ly > 0 ? row - tile : in + layout.offset (x0, y - 1);
+                const double *down = ly + 1 < tile ? row + tile : in + layout.offset (x0, y + 1);
+                double *out = output.data () + c;
+                for(hsize lx = first; lx < last; ++lx)
+                {
+                    double left = lx > 0 ? row[lx - 1] : in[layout.offset (x0 - 1, y)];
+                    double right = lx + 1 < tile ? row[lx + 1] : in[layout.offset (x0 + tile, y)];
+                    out[lx] = 0.2 * (row[lx] + left + right + up[lx] + down[lx]);
+                }
+            }
+        }
+        input.swap (output);
+    }
+    return std::chrono::duration<double>(Clock::now () - start).count ();
+}
+
+void report(const char *name, double seconds, hsize n, int iterations)
+{
+    double updates = double(n - 2) * (n - 2) * iterations;
+    std::cout << name << "\t" << seconds << " s\t" << updates / seconds / 1e6 << " Mupdates/s" << std::endl;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    hsize n = argc > 1 ? std::atoi(argv[1]) : 4096;
+    int iterations = argc > 2 ? std::atoi(argv[2]) : 10;
+
+    std::vector<double> image(std::size_t(n) * n);
+    for(std::size_t i = 0; i < image.size (); ++i)
+        image[i] = double(i % 1024);
+
+    std::vector<double> input = image, output = image;
+    report ("row-major", rowMajorStencil (input, output, n, iterations), n, iterations);
+    std::vector<double> reference = input;
+
+    for(hsize tile : {1u, 8u, 16u, 32u})
+    {
+        HilbertLayout layout(n, n, tile);
+        std::vector<double> in(layout.size ()), out(layout.size ());
+        layout.fromRowMajor (image.data (), n, in.data ());
+        layout.fromRowMajor (image.data (), n, out.data ());
+        double seconds = layoutStencil (layout, in, out, iterations);
+        std::vector<double> result(image.size ());
+        layout.toRowMajor (in.data (), result.data (), n);
+        std::string name = "hilbert/" + std::to_string(tile);
+        report (name.c_str (), seconds, n, iterations);
+        if(result != reference)
+            std::cout << name << " result differs from row-major" << std::endl;
+    }
+    return 0;
+}
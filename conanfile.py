@@ -13,7 +13,7 @@ class HilbertplotCoreConan(ConanFile):
     description = "Generate Hilbert's curve and hilbert plots"
     topics = ("data-visualization", "data-minig")
 
-    requires = ["cmake/3.16.3", "fftw/3.3.9"]
+    requires = ["cmake/3.16.3", "fftw/3.3.9", "zlib/1.2.13", "zstd/1.5.5"]
 
     # Binary configuration
     settings = "os", "compiler", "build_type", "arch"
@@ -33,7 +33,32 @@ SOURCES += \
         src/hilbertcurve.cpp \
     src/hpoint.cpp \
     src/datasequence.cpp \
-    src/hilbertplot.cpp
+    src/hilbertplot.cpp \
+    src/recurrenceplot.cpp \
+    src/numberparser.cpp \
+    src/mappedfile.cpp \
+    src/dataview.cpp \
+    src/binaryloader.cpp \
+    src/byteplot.cpp \
+    src/chunkedsequence.cpp \
+    src/csvloader.cpp \
+    src/compressedloader.cpp \
+    src/curvecache.cpp \
+    src/plotloader.cpp \
+    src/thumbnailloader.cpp \
+    src/hilbertplotbatch.cpp \
+    src/curveorder.cpp \
+    src/hilbertlayout.cpp \
+    src/hilbertkey.cpp \
+    src/hilbertrtree.cpp \
+    src/memoryresource.cpp \
+    src/hugepages.cpp \
+    src/compactcurve.cpp \
+    src/quantizedsequence.cpp \
+    src/plotsnapshot.cpp \
+    src/svgwriter.cpp \
+    src/textexporter.cpp \
+    src/rasterexporter.cpp
 
 HEADERS += \
         headers/hilbertcurve.h \
@@ -41,11 +66,46 @@ HEADERS += \
         headers/hilbertdefines.h \
         headers/hilbertdefines.h \
         headers/datasequence.h \
-        headers/hilbertplot.h
+        headers/hilbertplot.h \
+        headers/recurrenceplot.h \
+        headers/numberparser.h \
+        headers/mappedfile.h \
+        headers/dataview.h \
+        headers/binaryloader.h \
+        headers/byteplot.h \
+        headers/chunkedsequence.h \
+        headers/csvloader.h \
+        headers/compressedloader.h \
+        headers/curvecache.h \
+        headers/plotloader.h \
+        headers/thumbnailloader.h \
+        headers/hilbertplotbatch.h \
+        headers/curveorder.h \
+        headers/hilbertlayout.h \
+        headers/hilbertkey.h \
+        headers/hilbertrtree.h \
+        headers/memoryresource.h \
+        headers/hugepages.h \
+        headers/compactcurve.h \
+        headers/quantizedsequence.h \
+        headers/plotsnapshot.h \
+        headers/svgwriter.h \
+        headers/textexporter.h \
+        headers/rasterexporter.h
         ../common/threads_utility.h
 
 LIBS += -lfftw3
 
+# Optional decompression support for CompressedLoader, found with pkg-config
+packagesExist(zlib) {
+    DEFINES += HILBERT_HAS_ZLIB
+    LIBS += -lz
+}
+packagesExist(libzstd) {
+    DEFINES += HILBERT_HAS_ZSTD
+    LIBS += -lzstd
+}
+
 unix {
     target.path = /usr/lib
     INSTALLS += target
@@ -0,0 +1,39 @@
+#ifndef BINARYLOADER_H
+#define BINARYLOADER_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include "dataview.h"
+#include "hilbertdefines.h"
+
+
+class BinaryLoader
+{
+    public:
+        enum SampleType {Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64};
+        enum ByteOrder {LittleEndian, BigEndian};
+
+        struct NpyHeader
+        {
+            SampleType type;
+            ByteOrder order;
+            bool fortranOrder;
+            std::vector<std::size_t> shape;
+            std::size_t dataOffset;
+            std::size_t elements;
+        };
+
+        static DataView fromRaw(const std::string &path, SampleType type, ByteOrder order = LittleEndian,
+                                std::size_t offset = 0);
+        static DataView fromRaw(const char *data, std::size_t size, SampleType type, ByteOrder order = LittleEndian,
+                                std::shared_ptr<const void> owner = std::shared_ptr<const void>());
+        static DataView fromNpy(const std::string &path);
+        static NpyHeader readNpyHeader(const char *data, std::size_t size);
+
+        static std::size_t sampleSize(SampleType type);
+        static ByteOrder nativeByteOrder();
+};
+
+#endif // BINARYLOADER_H
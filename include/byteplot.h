@@ -0,0 +1,40 @@
+#ifndef BYTEPLOT_H
+#define BYTEPLOT_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "hilbertcurve.h"
+
+class MappedFile;
+
+class BytePlot : public HilbertCurve
+{
+    public:
+        enum Palette {Grayscale, ByteClass};
+
+        BytePlot();
+        explicit BytePlot(const std::string &path, hsize width = 0, hsize height = 0, CurveType type = H0);
+        BytePlot(const uint8_t *data, std::size_t size, hsize width = 0, hsize height = 0, CurveType type = H0,
+                 std::shared_ptr<const void> owner = std::shared_ptr<const void>());
+
+        std::size_t size() const;
+        const uint8_t *bytes() const;
+        uint8_t byteAt(std::size_t index) const;
+
+        std::vector<uint32_t> render(Palette palette = ByteClass) const;
+        std::vector<uint32_t> render(const std::vector<uint32_t> &colormap) const;
+
+        static std::vector<uint32_t> colormap(Palette palette);
+
+    private:
+        const uint8_t *m_bytes;
+        std::size_t m_size;
+        std::shared_ptr<const void> m_owner;
+
+        BytePlot(const std::shared_ptr<const MappedFile> &file, hsize width, hsize height, CurveType type);
+        static hsize cellCount(std::size_t size);
+};
+
+#endif // BYTEPLOT_H
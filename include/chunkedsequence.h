@@ -0,0 +1,78 @@
+#ifndef CHUNKEDSEQUENCE_H
+#define CHUNKEDSEQUENCE_H
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include "binaryloader.h"
+#include "dataview.h"
+#include "hilbertcurve.h"
+#include "hilbertdefines.h"
+#include "hilbertplot.h"
+
+static const std::size_t DEFAULT_CHUNK_SIZE = 1 << 20;
+static const std::size_t DEFAULT_RESIDENT_CHUNKS = 8;
+
+class ChunkedSequence
+{
+    public:
+        typedef std::size_t size_type;
+        typedef std::function<void(size_type offset, const DataView &chunk)> ChunkFunction;
+
+        struct Summary
+        {
+            size_type count;
+            hfloat min;
+            hfloat max;
+            hfloat mean;
+            hfloat stdDeviation;
+        };
+
+        ChunkedSequence(const std::string &path, BinaryLoader::SampleType type = BinaryLoader::Float64,
+                        BinaryLoader::ByteOrder order = BinaryLoader::LittleEndian, std::size_t offset = 0,
+                        size_type chunkSize = DEFAULT_CHUNK_SIZE, size_type residentChunks = DEFAULT_RESIDENT_CHUNKS);
+        ChunkedSequence(const ChunkedSequence &) = delete;
+        ChunkedSequence &operator=(const ChunkedSequence &) = delete;
+
+        size_type size() const;
+        bool empty() const;
+        size_type chunkSize() const;
+        size_type chunkCount() const;
+        size_type residentChunks() const;
+
+        DataView chunk(size_type index) const;
+        DataView range(size_type offset, size_type count) const;
+        hfloat at(size_type index) const;
+        void forEachChunk(const ChunkFunction &function) const;
+        void forEachChunk(size_type offset, size_type count, const ChunkFunction &function) const;
+
+        Summary summary() const;
+        hfloat Entropy() const;
+        void granularity(unsigned int n, const ChunkFunction &output) const;
+        HImage generateImage(hsize width = 0, hsize height = 0, HilbertCurve::CurveType type = HilbertCurve::H0,
+                             HilbertPlot::AggregationMode aggregation = HilbertPlot::Mean) const;
+
+    private:
+        typedef std::list<std::pair<size_type, DataView>> ChunkList;
+
+        std::string m_path;
+        BinaryLoader::SampleType m_type;
+        BinaryLoader::ByteOrder m_order;
+        std::size_t m_offset;
+        size_type m_size;
+        size_type m_chunkSize;
+        size_type m_residentChunks;
+
+        mutable std::mutex m_mutex;
+        mutable ChunkList m_resident;
+        mutable std::unordered_map<size_type, ChunkList::iterator> m_cache;
+
+        DataView load(size_type index) const;
+        void readAhead(size_type index) const;
+};
+
+#endif // CHUNKEDSEQUENCE_H
@@ -0,0 +1,87 @@
+#ifndef COMPACTCURVE_H
+#define COMPACTCURVE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+#include "hilbertcurve.h"
+#include "hilbertdefines.h"
+
+static const std::size_t DEFAULT_CHECKPOINT_INTERVAL = 1024;
+
+class CompactCurve
+{
+    public:
+        class const_iterator
+        {
+            public:
+                typedef std::forward_iterator_tag iterator_category;
+                typedef HPoint value_type;
+                typedef std::ptrdiff_t difference_type;
+                typedef const HPoint *pointer;
+                typedef const HPoint &reference;
+
+                const_iterator();
+
+                const HPoint &operator*() const;
+                const HPoint *operator->() const;
+                const_iterator &operator++();
+                const_iterator operator++(int);
+
+                bool operator==(const const_iterator &other) const;
+                bool operator!=(const const_iterator &other) const;
+
+            private:
+                friend class CompactCurve;
+                const_iterator(const CompactCurve *curve, std::size_t index);
+
+                const CompactCurve *m_curve;
+                std::size_t m_index;
+                std::size_t m_jump;
+                HPoint m_point;
+        };
+
+        CompactCurve();
+        explicit CompactCurve(const HilbertCurve &curve, std::size_t checkpointInterval = DEFAULT_CHECKPOINT_INTERVAL);
+
+        hsize lenght() const;
+        hsize width() const;
+        hsize height() const;
+        HilbertCurve::CurveType type() const;
+        hfloat meanDifference() const;
+        std::size_t checkpointInterval() const;
+        std::size_t jumps() const;
+        std::size_t memoryUsage() const;
+
+        HPoint operator[](std::size_t index) const;
+        void decode(std::size_t first, std::size_t count, hint *x, hint *y) const;
+        const_iterator begin() const;
+        const_iterator end() const;
+
+        HilbertCurve toCurve() const;
+
+    private:
+        struct Jump
+        {
+            std::size_t index;
+            hint x;
+            hint y;
+        };
+
+        hsize m_width;
+        hsize m_height;
+        HilbertCurve::CurveType m_type;
+        bool m_difference;
+        hfloat m_meanDifference;
+        std::size_t m_lenght;
+        std::size_t m_interval;
+        std::vector<uint8_t> m_steps;
+        std::vector<hint> m_checkpoints;
+        std::vector<Jump> m_jumps;
+
+        void locate(std::size_t index, hint &x, hint &y) const;
+        std::vector<Jump>::const_iterator jumpAfter(std::size_t index) const;
+};
+
+#endif // COMPACTCURVE_H
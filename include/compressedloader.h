@@ -0,0 +1,40 @@
+#ifndef COMPRESSEDLOADER_H
+#define COMPRESSEDLOADER_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include "binaryloader.h"
+#include "datasequence.h"
+#include "dataview.h"
+#include "hilbertdefines.h"
+
+static const std::size_t PIPELINE_BLOCK_SIZE = 4 << 20;
+
+class CompressedLoader
+{
+    public:
+        enum Compression {Auto, None, Gzip, Zstd};
+        typedef std::function<void(std::size_t offset, const DataView &values)> BlockFunction;
+
+        static DataSequence fromPlainText(const std::string &path, Compression compression = Auto);
+        static DataSequence fromRaw(const std::string &path, BinaryLoader::SampleType type,
+                                    BinaryLoader::ByteOrder order = BinaryLoader::LittleEndian,
+                                    Compression compression = Auto);
+
+        static std::size_t streamPlainText(const std::string &path, const BlockFunction &output,
+                                           Compression compression = Auto);
+        static std::size_t streamRaw(const std::string &path, BinaryLoader::SampleType type,
+                                     BinaryLoader::ByteOrder order, const BlockFunction &output,
+                                     Compression compression = Auto);
+
+        static std::size_t plainTextToRaw(const std::string &path, const std::string &rawPath,
+                                          Compression compression = Auto);
+        static std::size_t decompress(const std::string &path, const std::string &outputPath,
+                                      Compression compression = Auto);
+
+        static Compression detect(const std::string &path);
+        static bool isSupported(Compression compression);
+};
+
+#endif // COMPRESSEDLOADER_H
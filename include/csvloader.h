@@ -0,0 +1,46 @@
+#ifndef CSVLOADER_H
+#define CSVLOADER_H
+
+#include <cstddef>
+#include <limits>
+#include <string>
+#include <vector>
+#include "datasequence.h"
+#include "hilbertdefines.h"
+
+
+class CsvLoader
+{
+    public:
+        struct Options
+        {
+            Options(char delimiter = ',', bool header = true,
+                    hfloat missing = std::numeric_limits<hfloat>::quiet_NaN());
+
+            char delimiter;
+            char quote;
+            bool header;
+            hfloat missing;
+        };
+
+        struct Table
+        {
+            std::vector<std::string> names;
+            std::vector<DataSequence> columns;
+        };
+
+        static Table fromFile(const std::string &path, const std::vector<std::size_t> &columns = std::vector<std::size_t>(),
+                              const Options &options = Options());
+        static Table fromFile(const std::string &path, const std::vector<std::string> &columns,
+                              const Options &options = Options());
+        static Table fromText(const char *first, const char *last,
+                              const std::vector<std::size_t> &columns = std::vector<std::size_t>(),
+                              const Options &options = Options());
+        static Table fromText(const char *first, const char *last, const std::vector<std::string> &columns,
+                              const Options &options = Options());
+
+        static std::vector<std::string> readHeader(const char *first, const char *last, const Options &options = Options());
+        static char detectDelimiter(const char *first, const char *last);
+};
+
+#endif // CSVLOADER_H
@@ -0,0 +1,63 @@
+#ifndef CURVECACHE_H
+#define CURVECACHE_H
+
+#include <cstddef>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+#include "compactcurve.h"
+#include "hilbertcurve.h"
+
+static const std::size_t DEFAULT_CURVE_CACHE_CAPACITY = 8;
+static const std::size_t DEFAULT_COMPACT_CURVE_CAPACITY = 64;
+
+class CurveCache
+{
+    public:
+        typedef std::shared_ptr<const HilbertCurve> CurvePointer;
+        typedef std::shared_ptr<const CompactCurve> CompactPointer;
+
+        explicit CurveCache(std::size_t capacity = DEFAULT_CURVE_CACHE_CAPACITY,
+                            std::size_t compactCapacity = DEFAULT_COMPACT_CURVE_CAPACITY);
+        ~CurveCache();
+        CurveCache(const CurveCache &) = delete;
+        CurveCache &operator=(const CurveCache &) = delete;
+
+        CurvePointer curve(hsize width, hsize height, HilbertCurve::CurveType type = HilbertCurve::H0);
+        std::shared_future<CurvePointer> curveAsync(hsize width, hsize height,
+                                                    HilbertCurve::CurveType type = HilbertCurve::H0);
+
+        std::size_t size() const;
+        std::size_t capacity() const;
+        void setCapacity(std::size_t capacity);
+        std::size_t compactSize() const;
+        std::size_t compactCapacity() const;
+        void setCompactCapacity(std::size_t capacity);
+        void clear();
+
+        static CurveCache &instance();
+
+    private:
+        typedef std::tuple<hsize, hsize, int> Key;
+        typedef std::list<std::pair<Key, std::shared_future<CurvePointer>>> CurveList;
+        typedef std::list<std::pair<Key, CompactPointer>> CompactList;
+
+        std::size_t m_capacity;
+        std::size_t m_compactCapacity;
+        mutable std::mutex m_mutex;
+        CurveList m_curves;
+        std::map<Key, CurveList::iterator> m_index;
+        CompactList m_compactCurves;
+        std::map<Key, CompactList::iterator> m_compactIndex;
+        std::vector<std::future<void>> m_encodings;
+
+        void evict(CurveList &evicted);
+        void keepCompact(const CurveList &curves);
+        void trimCompact();
+};
+
+#endif // CURVECACHE_H
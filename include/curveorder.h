@@ -0,0 +1,23 @@
+#ifndef CURVEORDER_H
+#define CURVEORDER_H
+
+#include <cstddef>
+#include "datasequence.h"
+#include "hilbertcurve.h"
+
+static const std::size_t CURVE_ORDER_BLOCK_SIZE = 1 << 14;
+
+class CurveOrder
+{
+    public:
+        static void gather(const HilbertCurve &curve, const hfloat *image, std::size_t stride, hfloat *output);
+        static void gather(const HilbertCurve &curve, const HImage &image, hfloat *output);
+        static void scatter(const HilbertCurve &curve, const hfloat *values, hfloat *image, std::size_t stride);
+        static void scatter(const HilbertCurve &curve, const hfloat *values, HImage &image);
+
+        static DataSequence fromImage(const hfloat *image, hsize width, hsize height,
+                                      HilbertCurve::CurveType type = HilbertCurve::H0);
+        static DataSequence fromImage(const HImage &image, HilbertCurve::CurveType type = HilbertCurve::H0);
+};
+
+#endif // CURVEORDER_H
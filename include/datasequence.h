@@ -95,11 +95,17 @@ class DataSequence : public std::vector<hfloat>
         hfloat mean() const;
         hfloat stdDeviation() const;
         hfloat Entropy() const;
+        std::vector<hint> symbolize(hsize levels) const;
+        DataSequence blockEntropy(hsize maxLength, hsize levels = 2) const;
+        static hfloat entropyRate(const DataSequence &blockEntropy);
+        static hfloat excessEntropy(const DataSequence &blockEntropy);
 
         friend std::ostream & operator<<(std::ostream & out, DataSequence & data);
 
         static DataSequence fromPlainText(std::istream &input);
         static DataSequence fromPlainText(std::string &input);
+        static DataSequence fromPlainText(const char *first, const char *last);
+        static DataSequence fromPlainTextFile(const std::string &path);
         static std::string onlyNumbers(std::string &input_string);
         static bool isNumeric(char ch);
 };
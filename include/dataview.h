@@ -0,0 +1,98 @@
+#ifndef DATAVIEW_H
+#define DATAVIEW_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "hilbertdefines.h"
+
+class DataSequence;
+
+class DataView
+{
+    public:
+        typedef hfloat value_type;
+        typedef std::size_t size_type;
+        typedef const hfloat *const_iterator;
+        typedef const hfloat *iterator;
+
+        //Constructors
+        DataView();
+        DataView(const hfloat *data, size_type size, std::shared_ptr<const void> owner = std::shared_ptr<const void>());
+        explicit DataView(const std::vector<hfloat> &data);
+
+        const hfloat *data() const;
+        size_type size() const;
+        bool empty() const;
+        const_iterator begin() const;
+        const_iterator end() const;
+        const_iterator cbegin() const;
+        const_iterator cend() const;
+        const hfloat &operator[](size_type index) const;
+        const hfloat &at(size_type index) const;
+
+        DataView subview(size_type offset, size_type count) const;
+        DataSequence toSequence() const;
+        const std::shared_ptr<const void> &owner() const;
+
+        static DataView fromSequence(DataSequence &&data);
+
+        // Fourier
+        DataSequence fourierTransform(bool logflag) const;
+
+        /// Data information:
+        hfloat max() const;
+        hfloat min() const;
+        hfloat mean() const;
+        hfloat stdDeviation() const;
+        hfloat Entropy() const;
+        std::vector<hint> symbolize(hsize levels) const;
+        DataSequence blockEntropy(hsize maxLength, hsize levels = 2) const;
+
+    private:
+        const hfloat *m_data;
+        size_type m_size;
+        std::shared_ptr<const void> m_owner;
+};
+
+inline const hfloat *DataView::data() const
+{
+    return m_data;
+}
+
+inline DataView::size_type DataView::size() const
+{
+    return m_size;
+}
+
+inline bool DataView::empty() const
+{
+    return m_size == 0;
+}
+
+inline DataView::const_iterator DataView::begin() const
+{
+    return m_data;
+}
+
+inline DataView::const_iterator DataView::end() const
+{
+    return m_data + m_size;
+}
+
+inline DataView::const_iterator DataView::cbegin() const
+{
+    return m_data;
+}
+
+inline DataView::const_iterator DataView::cend() const
+{
+    return m_data + m_size;
+}
+
+inline const hfloat &DataView::operator[](size_type index) const
+{
+    return m_data[index];
+}
+
+#endif // DATAVIEW_H
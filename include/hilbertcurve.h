@@ -5,12 +5,14 @@
 
 #include "hpoint.h"
 #include "hilbertdefines.h"
+#include "memoryresource.h"
 
 class QuasiSquare
 {
     public:
 
         enum Orientation {A, B, C, D};
+        typedef std::vector<QuasiSquare, ResourceAllocator<QuasiSquare>> PartitionList;
 
         //class constructors
         QuasiSquare(const QuasiSquare & q);
@@ -28,7 +30,7 @@ class QuasiSquare
         HPoint coord; // Origen
         Orientation oABCD;
         //Partition function
-        std::vector<QuasiSquare> & Partition(std::vector<QuasiSquare> & partition_vec);
+        PartitionList & Partition(PartitionList & partition_vec);
 
 };
 
@@ -45,6 +47,9 @@ class HilbertCurve : protected QuasiSquare
         HilbertCurve(void);
         HilbertCurve(hsize width, hsize height, CurveType type = H0, HPoint origen = 0, Orientation orientation = A, bool differenceCurve = false);
         HilbertCurve(const HilbertCurve &curve);
+        HilbertCurve(HilbertCurve &&curve);
+        HilbertCurve &operator=(const HilbertCurve &curve) = default;
+        HilbertCurve &operator=(HilbertCurve &&curve) = default;
 
         hfloat meanDifference() const;
         hsize lenght() const;
@@ -58,11 +63,14 @@ class HilbertCurve : protected QuasiSquare
         const_iterator cbegin() const;
         const_iterator end() const;
         const_iterator cend() const;
-        void SaveSVG(const char* filename, const char* colorName, float stroke_width = 0.2);
-        std::string curveToSvg(const char* colorName = "red", float stroke_width = 0.2);
+        void SaveSVG(const char* filename, const char* colorName, float stroke_width = 0.2) const;
+        std::string curveToSvg(const char* colorName = "red", float stroke_width = 0.2) const;
 
         static HilbertCurve createCurve(hsize width, hsize height, CurveType type = H0, HPoint origen = 0, Orientation orientation = A, bool differenceCurve = false);
         friend class HilbertPlotForm;
+        friend class CompactCurve;
+        friend class PlotSnapshot;
+        friend class SvgWriter;
 
     private:
         CurveType m_type;
@@ -18,5 +18,6 @@ class HilbertBadOperation : public std::exception{};
 class HilbertIndexOutOfRange : public std::exception{};
 class HilbertZeroDivision : public std::exception{};
 class HilbertBadSize : public std::exception{};
+class HilbertIOError : public std::exception{};
 
 #endif // HILBERTDEFINES_H
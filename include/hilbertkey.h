@@ -0,0 +1,40 @@
+#ifndef HILBERTKEY_H
+#define HILBERTKEY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "hilbertdefines.h"
+
+static const unsigned HILBERT_KEY_ORDER = 32;
+
+class HilbertKey
+{
+    public:
+        struct Bounds
+        {
+            hfloat minX;
+            hfloat minY;
+            hfloat maxX;
+            hfloat maxY;
+        };
+        typedef std::pair<uint64_t, uint64_t> Range;
+
+        static uint64_t fromPoint(uint32_t x, uint32_t y, unsigned order = HILBERT_KEY_ORDER);
+        static std::pair<uint32_t, uint32_t> toPoint(uint64_t key, unsigned order = HILBERT_KEY_ORDER);
+
+        static void fromPoints(const uint32_t *x, const uint32_t *y, std::size_t count, uint64_t *keys,
+                               unsigned order = HILBERT_KEY_ORDER);
+        static void fromPoints(const hfloat *x, const hfloat *y, std::size_t count, const Bounds &bounds,
+                               uint64_t *keys, unsigned order = HILBERT_KEY_ORDER);
+        static uint32_t quantize(hfloat value, hfloat min, hfloat max, unsigned order = HILBERT_KEY_ORDER);
+        static Bounds boundsOf(const hfloat *x, const hfloat *y, std::size_t count);
+
+        static std::vector<Range> ranges(uint32_t minX, uint32_t minY, uint32_t maxX, uint32_t maxY,
+                                         unsigned order = HILBERT_KEY_ORDER, std::size_t maxRanges = 64);
+
+        static void sort(uint64_t *keys, std::size_t *values, std::size_t count);
+};
+
+#endif // HILBERTKEY_H
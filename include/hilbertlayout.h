@@ -0,0 +1,121 @@
+#ifndef HILBERTLAYOUT_H
+#define HILBERTLAYOUT_H
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "hilbertcurve.h"
+
+static const hsize DEFAULT_LAYOUT_TILE = 8;
+
+class HilbertLayout
+{
+    public:
+        HilbertLayout();
+        HilbertLayout(hsize width, hsize height, hsize tile = DEFAULT_LAYOUT_TILE,
+                      HilbertCurve::CurveType type = HilbertCurve::H0);
+
+        hsize width() const;
+        hsize height() const;
+        hsize tile() const;
+        std::size_t size() const;
+        std::size_t tileCount() const;
+        std::pair<hsize, hsize> tileOrigin(std::size_t tile) const;
+
+        std::size_t offset(hsize x, hsize y) const;
+        std::size_t tileOffset(std::size_t tile) const;
+
+        template <typename T>
+        void fromRowMajor(const T *image, std::size_t stride, T *output) const;
+        template <typename T>
+        void toRowMajor(const T *values, T *image, std::size_t stride) const;
+
+    private:
+        hsize m_width;
+        hsize m_height;
+        hsize m_tileShift;
+        hsize m_tileMask;
+        hsize m_tilesX;
+        std::vector<std::size_t> m_tileOffsets;
+        std::vector<std::pair<hsize, hsize>> m_tileOrigins;
+};
+
+inline hsize HilbertLayout::width() const
+{
+    return m_width;
+}
+
+inline hsize HilbertLayout::height() const
+{
+    return m_height;
+}
+
+inline hsize HilbertLayout::tile() const
+{
+    return m_tileMask + 1;
+}
+
+inline std::size_t HilbertLayout::size() const
+{
+    return m_tileOffsets.size () << (2 * m_tileShift);
+}
+
+inline std::size_t HilbertLayout::tileCount() const
+{
+    return m_tileOffsets.size ();
+}
+
+inline std::pair<hsize, hsize> HilbertLayout::tileOrigin(std::size_t tile) const
+{
+    return m_tileOrigins[tile];
+}
+
+inline std::size_t HilbertLayout::offset(hsize x, hsize y) const
+{
+    return m_tileOffsets[std::size_t(y >> m_tileShift) * m_tilesX + (x >> m_tileShift)]
+            + ((y & m_tileMask) << m_tileShift) + (x & m_tileMask);
+}
+
+inline std::size_t HilbertLayout::tileOffset(std::size_t tile) const
+{
+    return tile << (2 * m_tileShift);
+}
+
+template <typename T>
+void HilbertLayout::fromRowMajor(const T *image, std::size_t stride, T *output) const
+{
+    for(std::size_t t = 0; t < m_tileOrigins.size (); ++t)
+    {
+        hsize x0 = m_tileOrigins[t].first, y0 = m_tileOrigins[t].second;
+        hsize xEnd = std::min(x0 + tile (), m_width), yEnd = std::min(y0 + tile (), m_height);
+        T *base = output + tileOffset (t);
+        for(hsize y = y0; y < yEnd; ++y)
+        {
+            const T *row = image + y * stride;
+            T *tileRow = base + ((y - y0) << m_tileShift);
+            for(hsize x = x0; x < xEnd; ++x)
+                tileRow[x - x0] = row[x];
+        }
+    }
+}
+
+template <typename T>
+void HilbertLayout::toRowMajor(const T *values, T *image, std::size_t stride) const
+{
+    for(std::size_t t = 0; t < m_tileOrigins.size (); ++t)
+    {
+        hsize x0 = m_tileOrigins[t].first, y0 = m_tileOrigins[t].second;
+        hsize xEnd = std::min(x0 + tile (), m_width), yEnd = std::min(y0 + tile (), m_height);
+        const T *base = values + tileOffset (t);
+        for(hsize y = y0; y < yEnd; ++y)
+        {
+            T *row = image + y * stride;
+            const T *tileRow = base + ((y - y0) << m_tileShift);
+            for(hsize x = x0; x < xEnd; ++x)
+                row[x] = tileRow[x - x0];
+        }
+    }
+}
+
+#endif // HILBERTLAYOUT_H
@@ -2,17 +2,55 @@
 #define HILBERTPLOT_H
 
 #include "hilbertcurve.h"
+#include "compactcurve.h"
 #include "datasequence.h"
+#include "dataview.h"
+#include <algorithm>
+#include <cstddef>
+#include <memory>
 #include <utility>
 
 
 class HilbertPlot : public HilbertCurve
 {
     public:
+        enum AggregationMode {Truncate, Mean, Min, Max, MinMaxEnvelope, Last};
 
+        struct BlockAccumulator
+        {
+            BlockAccumulator() : first(0), last(0), min(0), max(0), sum(0), count(0) {}
+            void add(hfloat value)
+            {
+                if(count == 0)
+                    first = min = max = value;
+                min = std::min(min, value);
+                max = std::max(max, value);
+                sum += value;
+                last = value;
+                ++count;
+            }
+            hfloat value(AggregationMode aggregation) const;
+
+            hfloat first;
+            hfloat last;
+            hfloat min;
+            hfloat max;
+            hfloat sum;
+            std::size_t count;
+        };
 
         HilbertPlot();
-        HilbertPlot(const DataSequence &data, hsize width = 0, hsize height = 0, CurveType type = H0);
+        HilbertPlot(const DataSequence &data, hsize width = 0, hsize height = 0, CurveType type = H0,
+                    AggregationMode aggregation = Truncate);
+        HilbertPlot(DataSequence &&data, hsize width = 0, hsize height = 0, CurveType type = H0,
+                    AggregationMode aggregation = Truncate);
+        HilbertPlot(const DataView &data, hsize width = 0, hsize height = 0, CurveType type = H0,
+                    AggregationMode aggregation = Truncate);
+        HilbertPlot(const HilbertCurve &curve, const DataSequence &data, AggregationMode aggregation = Truncate);
+        HilbertPlot(const HilbertCurve &curve, DataSequence &&data, AggregationMode aggregation = Truncate);
+        HilbertPlot(const HilbertCurve &curve, const DataView &data, AggregationMode aggregation = Truncate);
+        HilbertPlot(HilbertCurve &&curve, const DataView &data, AggregationMode aggregation = Truncate);
+        HilbertPlot(const CompactCurve &curve, const DataView &data, AggregationMode aggregation = Truncate);
         HilbertPlot(const HilbertPlot &hilbertplot);
 
         std::vector<HPoint>::const_reference operator [] (std::vector<HPoint>::size_type index) const;
@@ -28,20 +66,31 @@ class HilbertPlot : public HilbertCurve
 
         hfloat min() const {return  m_min;}
         hfloat max() const {return  m_max;}
+        AggregationMode aggregation() const {return m_aggregation;}
 
         HImage generateImage(hfloat threshold = 0);
 
         DataSequence dataCopy() const;
+        DataView dataView() const;
         void replaceData(const DataSequence &data);
 
         DataSequence hpFourierTransform(bool logflag) const;
         static std::pair<hsize, hsize> bestDimensions(hsize lenght);
+        static const HilbertCurve constructCurve(hsize lenght, hsize &width, hsize &height, CurveType type);
+        static DataSequence aggregate(const DataView &data, std::size_t cells, AggregationMode aggregation);
+        static std::pair<std::size_t, std::size_t> aggregateBlock(std::size_t size, std::size_t cells, std::size_t cell);
+        friend class PlotSnapshot;
 
     private:
-        DataSequence m_data;
+        DataView m_data;
+        std::shared_ptr<DataSequence> m_storage;
         hfloat m_min;
         hfloat m_max;
+        AggregationMode m_aggregation;
         std::vector<std::vector<hint>> m_plotToCurve;
-        static const HilbertCurve constructCurve(hsize lenght, hsize &width, hsize &height, CurveType type);
+
+        void initialize();
+        void updateRange();
+        void detach(std::size_t size);
 };
 #endif // HILBERTPLOT_H
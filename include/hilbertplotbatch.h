@@ -0,0 +1,58 @@
+#ifndef HILBERTPLOTBATCH_H
+#define HILBERTPLOTBATCH_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "datasequence.h"
+#include "dataview.h"
+#include "hilbertplot.h"
+
+
+class HilbertPlotBatch
+{
+    public:
+        typedef std::shared_ptr<const HilbertCurve> CurvePointer;
+
+        HilbertPlotBatch();
+        HilbertPlotBatch(const std::vector<DataView> &channels, hsize width = 0, hsize height = 0,
+                         HilbertCurve::CurveType type = HilbertCurve::H0);
+        HilbertPlotBatch(std::vector<DataSequence> &&channels, hsize width = 0, hsize height = 0,
+                         HilbertCurve::CurveType type = HilbertCurve::H0);
+        HilbertPlotBatch(const CurvePointer &curve, const std::vector<DataView> &channels);
+
+        std::size_t channelCount() const;
+        const HilbertCurve &curve() const;
+        hsize lenght() const;
+        hsize width() const;
+        hsize height() const;
+
+        const DataView &channel(std::size_t channel) const;
+        hfloat valueAt(std::size_t channel, hsize index) const;
+        hfloat valueAt(std::size_t channel, hsize x, hsize y) const;
+        hfloat valueNormalizedAt(std::size_t channel, hsize index) const;
+        hfloat valueNormalizedAt(std::size_t channel, hsize x, hsize y) const;
+        hint indexOf(hint x, hint y) const;
+
+        hfloat min(std::size_t channel) const;
+        hfloat max(std::size_t channel) const;
+
+        std::vector<DataSequence> normalized() const;
+        std::vector<HImage> generateImages(hfloat threshold = 0) const;
+        std::vector<DataSequence> hpFourierTransforms(bool logflag) const;
+
+        HilbertPlot plot(std::size_t channel) const;
+
+    private:
+        CurvePointer m_curve;
+        std::vector<DataView> m_channels;
+        std::vector<hint> m_plotToCurve;
+        std::vector<hfloat> m_min;
+        std::vector<hfloat> m_max;
+
+        void initialize();
+        void checkChannel(std::size_t channel) const;
+        HImage generateImage(std::size_t channel, hfloat threshold) const;
+};
+
+#endif // HILBERTPLOTBATCH_H
@@ -0,0 +1,41 @@
+#ifndef HILBERTRTREE_H
+#define HILBERTRTREE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "hilbertkey.h"
+
+static const std::size_t DEFAULT_RTREE_NODE_SIZE = 16;
+
+class HilbertRTree
+{
+    public:
+        typedef HilbertKey::Bounds Bounds;
+
+        HilbertRTree();
+        HilbertRTree(const hfloat *x, const hfloat *y, std::size_t count,
+                     std::size_t nodeSize = DEFAULT_RTREE_NODE_SIZE);
+        HilbertRTree(const std::vector<hfloat> &x, const std::vector<hfloat> &y,
+                     std::size_t nodeSize = DEFAULT_RTREE_NODE_SIZE);
+
+        std::size_t size() const;
+        std::size_t nodeSize() const;
+        const Bounds &bounds() const;
+
+        std::vector<std::size_t> query(const Bounds &rect) const;
+        std::vector<std::size_t> nearest(hfloat x, hfloat y, std::size_t k) const;
+
+    private:
+        Bounds m_bounds;
+        std::size_t m_nodeSize;
+        std::vector<uint64_t> m_keys;
+        std::vector<std::size_t> m_ids;
+        std::vector<hfloat> m_x;
+        std::vector<hfloat> m_y;
+        std::vector<std::vector<Bounds>> m_levels;
+
+        void build();
+};
+
+#endif // HILBERTRTREE_H
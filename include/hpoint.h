@@ -61,6 +61,10 @@ class HPoint
 
         friend class HilbertCurve;
         friend class HilbertPlot;
+        friend class HilbertPlotBatch;
+        friend class CompactCurve;
+        friend class PlotSnapshot;
+        friend class SvgWriter;
         friend class QuasiSquare;
 
     protected:
@@ -0,0 +1,42 @@
+#ifndef HUGEPAGES_H
+#define HUGEPAGES_H
+
+#include <cstddef>
+#include "memoryresource.h"
+
+static const std::size_t HUGE_PAGE_SIZE = 2 << 20;
+static const std::size_t DEFAULT_HUGE_PAGE_THRESHOLD = 32 << 20;
+
+class HugePages
+{
+    public:
+        static bool isSupported();
+        static bool enabled();
+        static void setEnabled(bool enabled);
+        static std::size_t threshold();
+        static void setThreshold(std::size_t bytes);
+
+        static bool advise(const void *data, std::size_t bytes);
+        static std::size_t obtained(const void *data, std::size_t bytes);
+        static std::size_t obtained();
+};
+
+class HugePageResource : public MemoryResource
+{
+    public:
+        explicit HugePageResource(MemoryResource *upstream = MemoryResource::defaultResource());
+
+        std::size_t hugeBytes() const;
+
+        static HugePageResource *instance();
+
+    protected:
+        void *doAllocate(std::size_t bytes, std::size_t alignment) override;
+        void doDeallocate(void *pointer, std::size_t bytes, std::size_t alignment) override;
+
+    private:
+        MemoryResource *m_upstream;
+        std::atomic<std::size_t> m_hugeBytes;
+};
+
+#endif // HUGEPAGES_H
@@ -0,0 +1,45 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "hilbertdefines.h"
+
+
+class MappedFile
+{
+    public:
+        enum Advice {Normal, Sequential, Random, WillNeed, DontNeed};
+
+        MappedFile();
+        explicit MappedFile(const std::string &path);
+        MappedFile(const std::string &path, std::size_t offset, std::size_t lenght);
+        MappedFile(MappedFile &&other);
+        ~MappedFile();
+
+        MappedFile &operator=(MappedFile &&other);
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        const char *data() const;
+        std::size_t size() const;
+        bool isMapped() const;
+        void advise(std::size_t offset, std::size_t lenght, Advice advice) const;
+
+        static std::size_t pageSize();
+        static std::size_t fileSize(const std::string &path);
+        static void adviseFile(const std::string &path, std::size_t offset, std::size_t lenght, Advice advice);
+
+    private:
+        const char *m_data;
+        std::size_t m_size;
+        bool m_mapped;
+        std::size_t m_mapOffset;
+        std::vector<char> m_buffer;
+
+        void map(const std::string &path, std::size_t offset, std::size_t lenght);
+        void unmap();
+};
+
+#endif // MAPPEDFILE_H
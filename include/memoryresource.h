@@ -0,0 +1,147 @@
+#ifndef MEMORYRESOURCE_H
+#define MEMORYRESOURCE_H
+
+#include <atomic>
+#include <cstddef>
+#include <limits>
+#include <mutex>
+#include <vector>
+#include "hilbertdefines.h"
+
+static const std::size_t HILBERT_ALIGNMENT = 64;
+static const std::size_t DEFAULT_ARENA_BLOCK_SIZE = 64 << 10;
+
+struct MemoryStats
+{
+    std::size_t bytesAllocated;
+    std::size_t bytesFreed;
+    std::size_t allocations;
+    std::size_t deallocations;
+
+    std::size_t bytesInUse() const {return bytesAllocated - bytesFreed;}
+};
+
+class MemoryResource
+{
+    public:
+        class Scope
+        {
+            public:
+                explicit Scope(MemoryResource *resource);
+                ~Scope();
+                Scope(const Scope &) = delete;
+                Scope &operator=(const Scope &) = delete;
+
+                MemoryResource *resource() const;
+                MemoryStats stats() const;
+
+            private:
+                MemoryResource *m_resource;
+                MemoryResource *m_previous;
+                MemoryStats m_start;
+        };
+
+        MemoryResource();
+        virtual ~MemoryResource();
+        MemoryResource(const MemoryResource &) = delete;
+        MemoryResource &operator=(const MemoryResource &) = delete;
+
+        void *allocate(std::size_t bytes, std::size_t alignment = HILBERT_ALIGNMENT);
+        void deallocate(void *pointer, std::size_t bytes, std::size_t alignment = HILBERT_ALIGNMENT);
+        MemoryStats stats() const;
+
+        static MemoryResource *defaultResource();
+        static MemoryResource *current();
+
+    protected:
+        virtual void *doAllocate(std::size_t bytes, std::size_t alignment) = 0;
+        virtual void doDeallocate(void *pointer, std::size_t bytes, std::size_t alignment) = 0;
+
+    private:
+        std::atomic<std::size_t> m_bytesAllocated;
+        std::atomic<std::size_t> m_bytesFreed;
+        std::atomic<std::size_t> m_allocations;
+        std::atomic<std::size_t> m_deallocations;
+};
+
+class AlignedResource : public MemoryResource
+{
+    protected:
+        void *doAllocate(std::size_t bytes, std::size_t alignment) override;
+        void doDeallocate(void *pointer, std::size_t bytes, std::size_t alignment) override;
+};
+
+class ArenaResource : public MemoryResource
+{
+    public:
+        explicit ArenaResource(std::size_t blockSize = DEFAULT_ARENA_BLOCK_SIZE,
+                               MemoryResource *upstream = MemoryResource::defaultResource());
+        ~ArenaResource();
+
+        void release();
+        std::size_t capacity() const;
+
+    protected:
+        void *doAllocate(std::size_t bytes, std::size_t alignment) override;
+        void doDeallocate(void *pointer, std::size_t bytes, std::size_t alignment) override;
+
+    private:
+        struct Block
+        {
+            char *data;
+            std::size_t size;
+        };
+
+        std::size_t m_blockSize;
+        MemoryResource *m_upstream;
+        mutable std::mutex m_mutex;
+        std::vector<Block> m_blocks;
+        char *m_cursor;
+        char *m_end;
+};
+
+template <typename T>
+class ResourceAllocator
+{
+    public:
+        typedef T value_type;
+
+        ResourceAllocator(): m_resource(MemoryResource::defaultResource ()) {}
+        ResourceAllocator(MemoryResource *resource): m_resource(resource) {}
+        template <typename U>
+        ResourceAllocator(const ResourceAllocator<U> &other): m_resource(other.resource ()) {}
+
+        T *allocate(std::size_t count)
+        {
+            if(count > std::numeric_limits<std::size_t>::max () / sizeof(T))
+                throw HilbertBadAlloc();
+            return static_cast<T *>(m_resource->allocate (count * sizeof(T), alignment ()));
+        }
+        void deallocate(T *pointer, std::size_t count)
+        {
+            m_resource->deallocate (pointer, count * sizeof(T), alignment ());
+        }
+        MemoryResource *resource() const {return m_resource;}
+
+    private:
+        MemoryResource *m_resource;
+
+        static std::size_t alignment() {return alignof(T) > HILBERT_ALIGNMENT ? alignof(T) : HILBERT_ALIGNMENT;}
+};
+
+template <typename T, typename U>
+bool operator==(const ResourceAllocator<T> &a, const ResourceAllocator<U> &b)
+{
+    return a.resource () == b.resource ();
+}
+
+template <typename T, typename U>
+bool operator!=(const ResourceAllocator<T> &a, const ResourceAllocator<U> &b)
+{
+    return a.resource () != b.resource ();
+}
+
+template <typename T>
+using AlignedVector = std::vector<T, ResourceAllocator<T>>;
+
+#endif // MEMORYRESOURCE_H
@@ -0,0 +1,39 @@
+#ifndef NUMBERPARSER_H
+#define NUMBERPARSER_H
+
+#include <cstddef>
+#include <vector>
+#include "hilbertdefines.h"
+
+
+class NumberParser
+{
+    public:
+        static const char *skipToNumber(const char *first, const char *last);
+        static const char *parseNumber(const char *first, const char *last, hfloat &value, bool &valid);
+        static std::size_t parse(const char *first, const char *last, std::vector<hfloat> &values);
+        static std::size_t parseParallel(const char *first, const char *last, std::vector<hfloat> &values);
+        static std::size_t countNumbers(const char *first, const char *last);
+        static const char *nextBoundary(const char *first, const char *position, const char *last);
+
+        static bool isNumeric(char ch);
+        static bool isDigit(char ch);
+        static bool isSeparator(char ch);
+};
+
+inline bool NumberParser::isDigit(char ch)
+{
+    return static_cast<unsigned char>(ch - '0') < 10;
+}
+
+inline bool NumberParser::isNumeric(char ch)
+{
+    return isDigit (ch) || ch == '.' || ch == '-' || ch == '+';
+}
+
+inline bool NumberParser::isSeparator(char ch)
+{
+    return !isNumeric (ch) && ch != 'e';
+}
+
+#endif // NUMBERPARSER_H
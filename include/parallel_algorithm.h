@@ -80,4 +80,36 @@ void for_each_parallel(Iter first, Iter last, Func f)
         first_half.get();
     }
 }
+// Number of chunks for splitting length elements among the hardware threads,
+// keeping at least min_per_chunk elements on each chunk.
+inline unsigned long parallel_chunk_count(unsigned long length, unsigned long min_per_chunk)
+{
+    unsigned long hardware_threads = std::thread::hardware_concurrency ();
+    if(hardware_threads == 0)
+        hardware_threads = 2;
+    if(min_per_chunk == 0)
+        min_per_chunk = 1;
+    unsigned long chunks = (length + min_per_chunk - 1) / min_per_chunk;
+    return std::max(1ul, std::min(chunks, hardware_threads));
+}
+
+// Splits [0, length) in contiguous ranges and calls f(chunk, begin, end) for
+// each one concurrently. The first chunk runs on the calling thread.
+template <typename Func>
+void for_each_chunk_parallel(unsigned long length, unsigned long chunks, Func f)
+{
+    if(chunks == 0)
+        return;
+    std::vector<std::future<void>> futures;
+    futures.reserve (chunks - 1);
+    for(unsigned long c = 1; c < chunks; ++c)
+    {
+        unsigned long begin = length / chunks * c + std::min(c, length % chunks);
+        unsigned long end = begin + length / chunks + (c < length % chunks);
+        futures.push_back (std::async(std::launch::async, f, c, begin, end));
+    }
+    f(0ul, 0ul, length / chunks + (0 < length % chunks));
+    for(auto &future : futures)
+        future.get ();
+}
 #endif // PARALLEL_ALGORITHM_H
@@ -0,0 +1,26 @@
+#ifndef PLOTLOADER_H
+#define PLOTLOADER_H
+
+#include <cstddef>
+#include <string>
+#include "binaryloader.h"
+#include "curvecache.h"
+#include "hilbertplot.h"
+
+
+class PlotLoader
+{
+    public:
+        static HilbertPlot fromRaw(const std::string &path, BinaryLoader::SampleType type,
+                                   BinaryLoader::ByteOrder order = BinaryLoader::LittleEndian, std::size_t offset = 0,
+                                   hsize width = 0, hsize height = 0, HilbertCurve::CurveType curveType = HilbertCurve::H0,
+                                   CurveCache &cache = CurveCache::instance());
+        static HilbertPlot fromNpy(const std::string &path, hsize width = 0, hsize height = 0,
+                                   HilbertCurve::CurveType curveType = HilbertCurve::H0,
+                                   CurveCache &cache = CurveCache::instance());
+        static HilbertPlot fromPlainTextFile(const std::string &path, hsize width = 0, hsize height = 0,
+                                             HilbertCurve::CurveType curveType = HilbertCurve::H0,
+                                             CurveCache &cache = CurveCache::instance());
+};
+
+#endif // PLOTLOADER_H
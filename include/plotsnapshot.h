@@ -0,0 +1,38 @@
+#ifndef PLOTSNAPSHOT_H
+#define PLOTSNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "curvecache.h"
+#include "hilbertdefines.h"
+#include "hilbertplot.h"
+
+static const uint32_t PLOT_SNAPSHOT_VERSION = 1;
+
+class PlotSnapshot
+{
+    public:
+        enum Section {Curve = 1, Difference = 2, InverseMap = 4, All = Curve | Difference | InverseMap};
+
+        struct Info
+        {
+            uint32_t version;
+            unsigned sections;
+            hsize width;
+            hsize height;
+            HilbertCurve::CurveType type;
+            HilbertPlot::AggregationMode aggregation;
+            std::size_t values;
+            hfloat min;
+            hfloat max;
+            hfloat meanDifference;
+        };
+
+        static void save(const HilbertPlot &plot, const std::string &path, unsigned sections = All);
+        static HilbertPlot load(const std::string &path, bool mapped = true,
+                                CurveCache &cache = CurveCache::instance ());
+        static Info info(const std::string &path);
+};
+
+#endif // PLOTSNAPSHOT_H
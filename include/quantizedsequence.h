@@ -0,0 +1,67 @@
+#ifndef QUANTIZEDSEQUENCE_H
+#define QUANTIZEDSEQUENCE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include "datasequence.h"
+#include "dataview.h"
+#include "hilbertcurve.h"
+#include "hilbertdefines.h"
+#include "hilbertplot.h"
+#include "memoryresource.h"
+
+class QuantizedSequence
+{
+    public:
+        enum Format {UInt8, Int16, Float16, Float32};
+
+        QuantizedSequence();
+        QuantizedSequence(Format format, std::size_t size, hfloat scale = 1.0, hfloat offset = 0.0);
+
+        static QuantizedSequence quantize(const DataView &data, Format format);
+        static QuantizedSequence fromRaw(const void *samples, std::size_t size, Format format,
+                                         hfloat scale = 1.0, hfloat offset = 0.0);
+
+        Format format() const;
+        std::size_t size() const;
+        bool empty() const;
+        std::size_t sampleSize() const;
+        std::size_t bytes() const;
+        hfloat scale() const;
+        hfloat offset() const;
+        const void *samples() const;
+        void *samples();
+
+        hfloat operator[](std::size_t index) const;
+        hfloat at(std::size_t index) const;
+        void set(std::size_t index, hfloat value);
+
+        void decode(std::size_t first, std::size_t count, hfloat *output) const;
+        DataSequence toSequence() const;
+
+        hfloat max() const;
+        hfloat min() const;
+        std::pair<hfloat, hfloat> range() const;
+        hfloat mean() const;
+        hfloat stdDeviation() const;
+
+        DataSequence aggregate(std::size_t cells, HilbertPlot::AggregationMode aggregation) const;
+        HImage image(const HilbertCurve &curve) const;
+
+        static float halfToFloat(uint16_t half);
+        static uint16_t floatToHalf(float value);
+        static std::size_t sampleSize(Format format);
+
+    private:
+        Format m_format;
+        std::size_t m_size;
+        hfloat m_scale;
+        hfloat m_offset;
+        AlignedVector<uint8_t> m_samples;
+
+        template <typename Kernel>
+        void apply(Kernel &kernel) const;
+};
+
+#endif // QUANTIZEDSEQUENCE_H
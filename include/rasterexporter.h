@@ -0,0 +1,73 @@
+#ifndef RASTEREXPORTER_H
+#define RASTEREXPORTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include "binaryloader.h"
+#include "hilbertdefines.h"
+
+static const std::size_t RASTER_BUFFER_SIZE = 4 << 20;
+
+class RasterExporter
+{
+    public:
+        enum Format {Npy, Raw, Pgm, Ppm, Pfm};
+
+        struct Options
+        {
+            Options(BinaryLoader::SampleType type = BinaryLoader::Float32, hfloat minimum = 0, hfloat maximum = 1);
+
+            BinaryLoader::SampleType type;
+            BinaryLoader::ByteOrder order;
+            hfloat minimum;
+            hfloat maximum;
+        };
+
+        class TileWriter
+        {
+            public:
+                TileWriter(const std::string &path, hsize width, hsize height, Format format,
+                           const Options &options = Options());
+                ~TileWriter();
+                TileWriter(const TileWriter &) = delete;
+                TileWriter &operator=(const TileWriter &) = delete;
+
+                void writeTile(hsize x, hsize y, hsize width, hsize height, const hfloat *values);
+                void writeTile(hsize x, hsize y, const HImage &tile);
+                void close();
+
+                hsize width() const;
+                hsize height() const;
+                bool isMapped() const;
+
+            private:
+                hsize m_width;
+                hsize m_height;
+                Format m_format;
+                Options m_options;
+                std::size_t m_dataOffset;
+                std::size_t m_size;
+                char *m_data;
+                std::fstream m_file;
+                std::mutex m_mutex;
+        };
+
+        static void write(const hfloat *values, hsize width, hsize height, std::ostream &out, Format format,
+                          const Options &options = Options());
+        static void write(const HImage &image, std::ostream &out, Format format, const Options &options = Options());
+        static void save(const hfloat *values, hsize width, hsize height, const std::string &path, Format format,
+                         const Options &options = Options());
+        static void save(const HImage &image, const std::string &path, Format format, const Options &options = Options());
+        static void save(const HImage &image, const std::string &path, const Options &options = Options());
+        static void savePixels(const uint32_t *pixels, hsize width, hsize height, const std::string &path);
+
+        static std::string header(Format format, hsize width, hsize height, const Options &options = Options());
+        static std::size_t sampleSize(Format format, const Options &options = Options());
+        static Format detect(const std::string &path);
+};
+
+#endif // RASTEREXPORTER_H
@@ -0,0 +1,52 @@
+#ifndef RECURRENCEPLOT_H
+#define RECURRENCEPLOT_H
+
+#include <cstdint>
+#include <vector>
+#include "datasequence.h"
+#include "hilbertdefines.h"
+
+
+class RecurrencePlot
+{
+    public:
+        struct Quantification
+        {
+            unsigned long long points;
+            unsigned long long recurrences;
+            unsigned long long diagonalRecurrences;
+            hfloat recurrenceRate;
+            hfloat determinism;
+        };
+
+        RecurrencePlot();
+        RecurrencePlot(const DataSequence &data, hfloat epsilon, hsize dimension = 1, hsize delay = 1);
+
+        hsize size() const;
+        hsize wordsPerRow() const;
+        hfloat epsilon() const;
+        hsize dimension() const;
+        hsize delay() const;
+
+        bool isRecurrent(hsize i, hsize j) const;
+        const uint64_t *row(hsize i) const;
+        const std::vector<uint64_t> &bits() const;
+        unsigned long long recurrences() const;
+
+        HImage generateImage() const;
+
+        static Quantification quantify(const DataSequence &data, hfloat epsilon, hsize dimension = 1, hsize delay = 1,
+                                       hsize minLine = 2, hsize theilerWindow = 1);
+
+    private:
+        hsize m_size;
+        hsize m_words;
+        hfloat m_epsilon;
+        hsize m_dimension;
+        hsize m_delay;
+        std::vector<uint64_t> m_bits;
+
+        static hsize embeddedSize(hsize lenght, hsize dimension, hsize delay);
+};
+
+#endif // RECURRENCEPLOT_H
@@ -0,0 +1,44 @@
+#ifndef SVGWRITER_H
+#define SVGWRITER_H
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include "hilbertcurve.h"
+#include "hilbertdefines.h"
+
+static const std::size_t SVG_BUFFER_SIZE = 1 << 20;
+static const std::size_t SVG_CHUNK_STEPS = 1 << 18;
+
+class SvgWriter
+{
+    public:
+        struct Options
+        {
+            Options(const char *color = "red", float strokeWidth = 0.2f);
+
+            std::string color;
+            float strokeWidth;
+            bool simplify;
+            bool relative;
+            unsigned int threads;
+        };
+
+        static void write(const HilbertCurve &curve, std::ostream &out, const Options &options = Options());
+        static void save(const HilbertCurve &curve, const std::string &path, const Options &options = Options());
+        static std::string toString(const HilbertCurve &curve, const Options &options = Options());
+
+    private:
+        struct Step
+        {
+            long long dx;
+            long long dy;
+        };
+
+        static Step stepAt(const HPoint *points, std::size_t i);
+        static bool continues(const Step &run, const Step &step);
+        static void formatSteps(const HPoint *points, std::size_t begin, std::size_t end, long long x, long long y,
+                                const Options &options, std::string &out);
+};
+
+#endif // SVGWRITER_H
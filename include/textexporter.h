@@ -0,0 +1,37 @@
+#ifndef TEXTEXPORTER_H
+#define TEXTEXPORTER_H
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include "dataview.h"
+#include "hilbertdefines.h"
+
+static const std::size_t TEXT_EXPORT_CHUNK_SIZE = 1 << 16;
+static const std::size_t TEXT_EXPORT_BUFFER_SIZE = 1 << 20;
+static const std::size_t TEXT_EXPORT_MAX_LENGTH = 32;
+
+class TextExporter
+{
+    public:
+        struct Options
+        {
+            Options(const std::string &separator = "\n", int precision = 0, std::size_t columns = 0);
+
+            std::string separator;
+            int precision;
+            std::size_t columns;
+            unsigned int threads;
+        };
+
+        static std::size_t format(hfloat value, char *output, int precision = 0);
+        static std::string toString(hfloat value, int precision = 0);
+
+        static void write(const DataView &data, std::ostream &out, const Options &options = Options());
+        static void write(const HImage &image, std::ostream &out, const Options &options = Options(" "));
+        static void save(const DataView &data, const std::string &path, const Options &options = Options());
+        static void save(const HImage &image, const std::string &path, const Options &options = Options(" "));
+        static std::string toString(const DataView &data, const Options &options = Options());
+};
+
+#endif // TEXTEXPORTER_H
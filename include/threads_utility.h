@@ -8,6 +8,8 @@
 #include <functional>
 #include <vector>
 #include <future>
+#include <condition_variable>
+#include <deque>
 
 class scoped_thread
 {
@@ -163,6 +165,56 @@ class thread_pool
         }
 };
 
+template<typename T>
+class bounded_queue
+{
+    public:
+        explicit bounded_queue(std::size_t capacity):
+            m_capacity(capacity > 0 ? capacity : 1), m_closed(false)
+        {}
+        bounded_queue(const bounded_queue&)= delete;
+        bounded_queue& operator=(const bounded_queue&)= delete;
+
+        // Waits while the queue is full. Returns false if it was closed.
+        bool push(T value)
+        {
+            std::unique_lock<std::mutex> lck(m_mutex);
+            m_not_full.wait (lck, [this]{ return m_closed || m_items.size () < m_capacity; });
+            if(m_closed)
+                return false;
+            m_items.push_back (std::move(value));
+            m_not_empty.notify_one ();
+            return true;
+        }
+        // Waits while the queue is empty. Returns false once it's closed and empty.
+        bool pop(T &value)
+        {
+            std::unique_lock<std::mutex> lck(m_mutex);
+            m_not_empty.wait (lck, [this]{ return m_closed || !m_items.empty (); });
+            if(m_items.empty ())
+                return false;
+            value = std::move(m_items.front ());
+            m_items.pop_front ();
+            m_not_full.notify_one ();
+            return true;
+        }
+        // Ends the queue: pending items can still be popped, pushes fail.
+        void close()
+        {
+            std::unique_lock<std::mutex> lck(m_mutex);
+            m_closed = true;
+            m_not_empty.notify_all ();
+            m_not_full.notify_all ();
+        }
+    private:
+        std::size_t m_capacity;
+        bool m_closed;
+        std::deque<T> m_items;
+        std::mutex m_mutex;
+        std::condition_variable m_not_empty;
+        std::condition_variable m_not_full;
+};
+
 #endif // SCOPED_THREAD_H
 
 
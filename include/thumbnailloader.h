@@ -0,0 +1,61 @@
+#ifndef THUMBNAILLOADER_H
+#define THUMBNAILLOADER_H
+
+#include <cstddef>
+#include <exception>
+#include <string>
+#include <vector>
+#include "binaryloader.h"
+#include "curvecache.h"
+#include "hilbertdefines.h"
+#include "hilbertplot.h"
+
+static const hsize DEFAULT_THUMBNAIL_SIZE = 64;
+
+class ThumbnailLoader
+{
+    public:
+        enum Format {PlainText, Raw};
+
+        struct Options
+        {
+            Options(hsize width = DEFAULT_THUMBNAIL_SIZE, hsize height = DEFAULT_THUMBNAIL_SIZE,
+                    HilbertCurve::CurveType type = HilbertCurve::H0);
+
+            hsize width;
+            hsize height;
+            HilbertCurve::CurveType type;
+            Format format;
+            BinaryLoader::SampleType sampleType;
+            BinaryLoader::ByteOrder byteOrder;
+            unsigned int readers;
+            std::size_t queueCapacity;
+            unsigned int workers;
+            HilbertPlot::AggregationMode aggregation;
+        };
+
+        struct Timing
+        {
+            double read;
+            double parse;
+            double render;
+        };
+
+        struct Thumbnail
+        {
+            std::string path;
+            std::size_t values;
+            HImage image;
+            Timing timing;
+            std::exception_ptr error;
+        };
+
+        static std::vector<Thumbnail> load(const std::vector<std::string> &paths, const Options &options = Options(),
+                                           CurveCache &cache = CurveCache::instance());
+        static HImage render(const DataView &values, const HilbertCurve &curve,
+                             HilbertPlot::AggregationMode aggregation = HilbertPlot::Mean);
+        static HImage mosaic(const std::vector<Thumbnail> &thumbnails, hsize columns, hsize spacing = 0,
+                             hfloat background = 0);
+};
+
+#endif // THUMBNAILLOADER_H
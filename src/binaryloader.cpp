@@ -0,0 +1,254 @@
+/*!
+   \headerfile "binaryloader.h"
+
+   \title Binary Loader Declaration
+
+   \brief The "binaryloader.h" header define BinaryLoader class
+ */
+#include "binaryloader.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+
+#include "datasequence.h"
+#include "mappedfile.h"
+#include "parallel_algorithm.h"
+
+namespace
+{
+const char NPY_MAGIC[] = "\x93NUMPY";
+const std::size_t NPY_MAGIC_SIZE = 6;
+
+template <typename T>
+inline T loadSample(const char *p, bool swap)
+{
+    unsigned char bytes[sizeof(T)];
+    std::memcpy(bytes, p, sizeof(T));
+    if(swap)
+    {
+        for(std::size_t i = 0; i < sizeof(T) / 2; ++i)
+            std::swap(bytes[i], bytes[sizeof(T) - 1 - i]);
+    }
+    T value;
+    std::memcpy(&value, bytes, sizeof(T));
+    return value;
+}
+
+// Converts count samples of type T at data to hfloat, in parallel.
+template <typename T>
+void widen(const char *data, std::size_t count, bool swap, hfloat *output)
+{
+    for_each_chunk_parallel (count, parallel_chunk_count (count, 1 << 18),
+                             [=](unsigned long, unsigned long begin, unsigned long end)
+    {
+        for(unsigned long i = begin; i < end; ++i)
+            output[i] = static_cast<hfloat>(loadSample<T>(data + i * sizeof(T), swap));
+    });
+}
+
+// Returns the text following "'key':" on the npy header dictionary.
+std::string npyValue(const std::string &header, const char *key)
+{
+    std::string quoted = std::string("'") + key + "'";
+    std::string::size_type position = header.find (quoted);
+    if(position == std::string::npos)
+        throw HilbertIOError();
+    position = header.find (':', position + quoted.size ());
+    if(position == std::string::npos)
+        throw HilbertIOError();
+    position = header.find_first_not_of (' ', position + 1);
+    if(position == std::string::npos)
+        throw HilbertIOError();
+    return header.substr (position);
+}
+}
+
+/*!
+   \class BinaryLoader
+   \inmodule hilbertlib
+   \ingroup hdata
+   \brief The \c BinaryLoader class loads binary captures as DataView.
+
+   Raw files of 8, 16 and 32 bits integers or 32 and 64 bits floats, in little
+   or big endian byte order, and NumPy \c .npy files are supported. Files are
+   memory mapped. When the samples are native \c hfloat values the returned
+   view points directly into the mapping, which it keeps alive, so nothing is
+   copied. Other types are widened to \c hfloat in parallel into a buffer owned
+   by the view.
+
+   \note HilbertIOError exception is thrown if the file can't be read or isn't valid.
+*/
+
+/*!
+  \brief Load a raw binary file.
+
+  Maps the file at \a path and returns its samples of \a type stored with
+  \a order byte order, skipping \a offset header bytes. Trailing bytes not
+  forming a whole sample are ignored.
+*/
+DataView BinaryLoader::fromRaw(const std::string &path, SampleType type, ByteOrder order, std::size_t offset)
+{
+    std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>(path);
+    if(offset > file->size ())
+        throw HilbertIOError();
+    file->advise (offset, file->size () - offset, MappedFile::Sequential);
+    return fromRaw (file->data () + offset, file->size () - offset, type, order, file);
+}
+/*!
+  \overload fromRaw()
+
+  Returns the samples of \a type and \a order in the \a size bytes at \a data.
+  When no conversion is needed the view refers to \a data and shares \a owner,
+  otherwise it owns a converted copy.
+*/
+DataView BinaryLoader::fromRaw(const char *data, std::size_t size, SampleType type, ByteOrder order,
+                               std::shared_ptr<const void> owner)
+{
+    std::size_t count = size / sampleSize (type);
+    bool swap = order != nativeByteOrder ();
+
+    if(type == Float64 && !swap && reinterpret_cast<std::uintptr_t>(data) % alignof(hfloat) == 0)
+        return DataView(reinterpret_cast<const hfloat *>(data), count, owner);
+
+    DataSequence values;
+    try
+    {
+        values.resize (count);
+    }
+    catch (std::bad_alloc& ba)
+    {
+        throw HilbertBadAlloc();
+    }
+    hfloat *output = values.data ();
+    switch (type)
+    {
+        case Int8:    widen<int8_t>(data, count, swap, output); break;
+        case UInt8:   widen<uint8_t>(data, count, swap, output); break;
+        case Int16:   widen<int16_t>(data, count, swap, output); break;
+        case UInt16:  widen<uint16_t>(data, count, swap, output); break;
+        case Int32:   widen<int32_t>(data, count, swap, output); break;
+        case UInt32:  widen<uint32_t>(data, count, swap, output); break;
+        case Float32: widen<float>(data, count, swap, output); break;
+        case Float64: widen<double>(data, count, swap, output); break;
+    }
+    return DataView::fromSequence (std::move(values));
+}
+/*!
+  \brief Load a NumPy \c .npy file.
+
+  Maps the file at \a path and returns its elements in storage order, whatever
+  its shape. Supported types are the integer and floating point types handled
+  by fromRaw().
+*/
+DataView BinaryLoader::fromNpy(const std::string &path)
+{
+    std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>(path);
+    NpyHeader header = readNpyHeader (file->data (), file->size ());
+    std::size_t bytes = header.elements * sampleSize (header.type);
+    if(file->size () - header.dataOffset < bytes)
+        throw HilbertIOError();
+    file->advise (header.dataOffset, bytes, MappedFile::Sequential);
+    return fromRaw (file->data () + header.dataOffset, bytes, header.type, header.order, file);
+}
+/*!
+  \brief Parse the header of a NumPy file.
+
+  Reads the header at the begining of the \a size bytes at \a data, returning
+  the element type, the shape and where the data starts.
+*/
+BinaryLoader::NpyHeader BinaryLoader::readNpyHeader(const char *data, std::size_t size)
+{
+    if(size < NPY_MAGIC_SIZE + 4 || std::memcmp(data, NPY_MAGIC, NPY_MAGIC_SIZE) != 0)
+        throw HilbertIOError();
+
+    unsigned char major = data[NPY_MAGIC_SIZE];
+    std::size_t headerLenght;
+    std::size_t headerStart;
+    if(major == 1)
+    {
+        headerLenght = loadSample<uint16_t>(data + 8, nativeByteOrder () != LittleEndian);
+        headerStart = 10;
+    }
+    else if((major == 2 || major == 3) && size >= 12)
+    {
+        headerLenght = loadSample<uint32_t>(data + 8, nativeByteOrder () != LittleEndian);
+        headerStart = 12;
+    }
+    else
+    {
+        throw HilbertIOError();
+    }
+    if(size - headerStart < headerLenght)
+        throw HilbertIOError();
+
+    std::string text(data + headerStart, headerLenght);
+    NpyHeader header;
+    header.dataOffset = headerStart + headerLenght;
+
+    // Type descriptor like '<f8'
+    std::string descr = npyValue (text, "descr");
+    if(descr.size () < 5 || descr[0] != '\'')
+        throw HilbertIOError();
+    char byteOrder = descr[1];
+    char kind = descr[2];
+    int bytes = std::atoi(descr.c_str () + 3);
+    header.order = byteOrder == '>' ? BigEndian : byteOrder == '<' ? LittleEndian : nativeByteOrder ();
+    if(kind == 'f' && bytes == 8) header.type = Float64;
+    else if(kind == 'f' && bytes == 4) header.type = Float32;
+    else if(kind == 'i' && bytes == 1) header.type = Int8;
+    else if(kind == 'u' && bytes == 1) header.type = UInt8;
+    else if(kind == 'b' && bytes == 1) header.type = UInt8;
+    else if(kind == 'i' && bytes == 2) header.type = Int16;
+    else if(kind == 'u' && bytes == 2) header.type = UInt16;
+    else if(kind == 'i' && bytes == 4) header.type = Int32;
+    else if(kind == 'u' && bytes == 4) header.type = UInt32;
+    else throw HilbertBadOperation();
+
+    header.fortranOrder = npyValue (text, "fortran_order").compare (0, 4, "True") == 0;
+
+    // Shape like (3, 4) or (5,) or ()
+    std::string shape = npyValue (text, "shape");
+    if(shape.empty () || shape[0] != '(')
+        throw HilbertIOError();
+    header.elements = 1;
+    const char *p = shape.c_str () + 1;
+    while(*p && *p != ')')
+    {
+        char *end;
+        unsigned long long dimension = std::strtoull(p, &end, 10);
+        if(end == p)
+        {
+            ++p;
+            continue;
+        }
+        header.shape.push_back (dimension);
+        header.elements *= dimension;
+        p = end;
+    }
+    return header;
+}
+/*!
+  Returns the size in bytes of a sample of \a type.
+*/
+std::size_t BinaryLoader::sampleSize(SampleType type)
+{
+    switch (type)
+    {
+        case Int8: case UInt8: return 1;
+        case Int16: case UInt16: return 2;
+        case Int32: case UInt32: case Float32: return 4;
+        case Float64: return 8;
+    }
+    return 1;
+}
+/*!
+  Returns the byte order of the running system.
+*/
+BinaryLoader::ByteOrder BinaryLoader::nativeByteOrder()
+{
+    const uint16_t probe = 1;
+    unsigned char first;
+    std::memcpy(&first, &probe, 1);
+    return first ? LittleEndian : BigEndian;
+}
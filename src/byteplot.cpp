@@ -0,0 +1,180 @@
+/*!
+   \headerfile "byteplot.h"
+
+   \title Byte Plot Declaration
+
+   \brief The "byteplot.h" header define BytePlot class
+ */
+#include "byteplot.h"
+#include <algorithm>
+#include <limits>
+
+#include "hilbertplot.h"
+#include "mappedfile.h"
+#include "parallel_algorithm.h"
+
+/*!
+   \class BytePlot
+   \inmodule hilbertlib
+   \ingroup hcurve
+   \brief The \c BytePlot class maps the bytes of a file along a HilbertCurve.
+
+   Each byte is kept as an \c uint8_t, the file being memory mapped, so plotting
+   a file takes little more memory than the curve itself. The curve is built
+   the same way HilbertPlot builds it, see HilbertPlot::constructCurve(), so a
+   BytePlot and a HilbertPlot of the same lenght and type share their layout.
+
+   Rendering translates each byte through a 256 entries colormap, either a
+   predefined Palette or one given by the caller. Cells beyond the end of the
+   data are rendered as byte zero.
+*/
+
+/*!
+  \enum BytePlot::Palette
+
+  \value Grayscale
+         Each byte value is a gray level, from black for 0x00 to white for 0xFF.
+  \value ByteClass
+         Bytes are colored by class: 0x00 black, 0xFF white, printable ASCII blue,
+         other ASCII control characters green and bytes with the high bit set red.
+*/
+
+/*!
+  Constructs an empty BytePlot.
+*/
+BytePlot::BytePlot():
+    BytePlot(nullptr, 0)
+{}
+/*!
+  Constructs the plot of the file at \a path using a curve of \a type. If
+  \a width and \a height are zero best dimensions are computed.
+  \note HilbertIOError exception is thrown if the file can't be read.
+*/
+BytePlot::BytePlot(const std::string &path, hsize width, hsize height, CurveType type):
+    BytePlot(std::make_shared<const MappedFile>(path), width, height, type)
+{}
+/*!
+  Constructs the plot of the \a size bytes at \a data using a curve of \a type.
+  The bytes aren't copied; if \a owner is given it's kept alive by the plot,
+  otherwise the caller must guarantee the memory outlives it.
+*/
+BytePlot::BytePlot(const uint8_t *data, std::size_t size, hsize width, hsize height, CurveType type,
+                   std::shared_ptr<const void> owner):
+    HilbertCurve(HilbertPlot::constructCurve (cellCount (size), width, height, type)),
+    m_bytes(data), m_size(size), m_owner(std::move(owner))
+{
+    std::size_t cells = static_cast<std::size_t>(width) * height;
+    if(m_size > cells)
+        m_size = cells;
+}
+
+BytePlot::BytePlot(const std::shared_ptr<const MappedFile> &file, hsize width, hsize height, CurveType type):
+    BytePlot(reinterpret_cast<const uint8_t *>(file->data ()), file->size (), width, height, type, file)
+{
+    file->advise (0, file->size (), MappedFile::Sequential);
+}
+/*!
+  Returns the number of plotted bytes.
+*/
+std::size_t BytePlot::size() const
+{
+    return m_size;
+}
+/*!
+  Returns the plotted bytes.
+*/
+const uint8_t *BytePlot::bytes() const
+{
+    return m_bytes;
+}
+/*!
+  Returns the byte at \a index of the curve, zero for the padding cells.
+  \note HilbertIndexOutOfRange() exception is thrown if the given index isn't valid.
+*/
+uint8_t BytePlot::byteAt(std::size_t index) const
+{
+    if(index >= lenght ())
+        throw HilbertIndexOutOfRange();
+    return index < m_size ? m_bytes[index] : 0;
+}
+/*!
+  Returns the plot as a row-major image of width() x height() ARGB pixels
+  colored with \a palette.
+*/
+std::vector<uint32_t> BytePlot::render(Palette palette) const
+{
+    return render (colormap (palette));
+}
+/*!
+  \overload render()
+
+  Colors each byte with the entry of \a colormap at its value.
+  \note HilbertBadSize exception is thrown if \a colormap doesn't have 256 entries.
+*/
+std::vector<uint32_t> BytePlot::render(const std::vector<uint32_t> &colormap) const
+{
+    if(colormap.size () != 256)
+        throw HilbertBadSize();
+
+    std::vector<uint32_t> image;
+    try
+    {
+        image.resize (static_cast<std::size_t>(width ()) * height ());
+    }
+    catch (std::bad_alloc& ba)
+    {
+        throw HilbertBadAlloc();
+    }
+
+    const uint32_t *lut = colormap.data ();
+    uint32_t *pixels = image.data ();
+    std::size_t rowLenght = width ();
+    hsize cells = lenght ();
+    for_each_chunk_parallel (cells, parallel_chunk_count (cells, 1 << 16),
+                             [&](unsigned long, unsigned long begin, unsigned long end)
+    {
+        // Bytes up to last, padding after it
+        unsigned long last = std::min<unsigned long>(end, std::max<unsigned long>(begin, m_size));
+        for(unsigned long i = begin; i < last; ++i)
+        {
+            const HPoint &point = HilbertCurve::operator [] (i);
+            pixels[point.Y () * rowLenght + point.X ()] = lut[m_bytes[i]];
+        }
+        for(unsigned long i = last; i < end; ++i)
+        {
+            const HPoint &point = HilbertCurve::operator [] (i);
+            pixels[point.Y () * rowLenght + point.X ()] = lut[0];
+        }
+    });
+    return image;
+}
+/*!
+  Returns the 256 entries ARGB colormap of \a palette.
+*/
+std::vector<uint32_t> BytePlot::colormap(Palette palette)
+{
+    std::vector<uint32_t> lut(256);
+    for(uint32_t value = 0; value < 256; ++value)
+    {
+        if(palette == Grayscale)
+            lut[value] = 0xFF000000u | value << 16 | value << 8 | value;
+        else if(value == 0x00)
+            lut[value] = 0xFF000000u;
+        else if(value == 0xFF)
+            lut[value] = 0xFFFFFFFFu;
+        else if(value >= 0x20 && value < 0x7F)
+            lut[value] = 0xFF377EB8u;
+        else if(value < 0x80)
+            lut[value] = 0xFF4DAF4Au;
+        else
+            lut[value] = 0xFFE41A1Cu;
+    }
+    return lut;
+}
+
+hsize BytePlot::cellCount(std::size_t size)
+{
+    if(size > std::numeric_limits<hsize>::max ())
+        return std::numeric_limits<hsize>::max ();
+    return static_cast<hsize>(size);
+}
@@ -0,0 +1,445 @@
+/*!
+   \headerfile "chunkedsequence.h"
+
+   \title Chunked Sequence Declaration
+
+   \brief The "chunkedsequence.h" header define ChunkedSequence class
+ */
+#include "chunkedsequence.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+
+#include "datasequence.h"
+#include "hilbertplot.h"
+#include "mappedfile.h"
+
+namespace
+{
+hfloat zlog(hfloat val)
+{
+    return val > 0 ? std::log(val) : 0;
+}
+}
+
+/*!
+   \class ChunkedSequence
+   \inmodule hilbertlib
+   \ingroup hdata
+   \brief The \c ChunkedSequence class gives access to a binary capture bigger
+   than the memory.
+
+   The file holds samples of one of the BinaryLoader::SampleType types and is
+   split in chunks of chunkSize() samples. Each chunk is a separate memory
+   mapped window of the file, converted to \c hfloat if needed, and returned as
+   a DataView. At most residentChunks() chunks are kept, the least recently
+   used one being released when another one is loaded, so memory use is
+   bounded whatever the file size. Loading a chunk asks the kernel to read the
+   next one in background, so sequential scans don't wait for the disk.
+
+   The statistics, granularity and image generation stream over the chunks in
+   order instead of loading the whole file.
+
+   A ChunkedSequence can be used from several threads. Views returned by
+   chunk() and range() remain valid after the chunk is evicted.
+
+   \note HilbertIOError exception is thrown if the file can't be read.
+*/
+
+/*!
+  \class ChunkedSequence::Summary
+  \inmodule hilbertlib
+  \brief Number of values, minimum, maximum, mean and standard deviation of
+  a ChunkedSequence, computed in a single pass by summary().
+*/
+
+/*!
+  Opens the file at \a path holding samples of \a type stored with \a order
+  byte order after \a offset header bytes. Chunks have \a chunkSize samples and
+  up to \a residentChunks of them are kept in memory.
+  \note HilbertBadOperation exception is thrown if \a chunkSize or \a residentChunks is zero.
+*/
+ChunkedSequence::ChunkedSequence(const std::string &path, BinaryLoader::SampleType type,
+                                 BinaryLoader::ByteOrder order, std::size_t offset,
+                                 size_type chunkSize, size_type residentChunks):
+    m_path(path), m_type(type), m_order(order), m_offset(offset), m_size(0),
+    m_chunkSize(chunkSize), m_residentChunks(residentChunks)
+{
+    if(chunkSize == 0 || residentChunks == 0)
+        throw HilbertBadOperation();
+    std::size_t bytes = MappedFile::fileSize (path);
+    if(offset > bytes)
+        throw HilbertIOError();
+    m_size = (bytes - offset) / BinaryLoader::sampleSize (type);
+    readAhead (0);
+}
+/*!
+  Returns the number of values.
+*/
+ChunkedSequence::size_type ChunkedSequence::size() const
+{
+    return m_size;
+}
+/*!
+  Returns \c true if there are no values.
+*/
+bool ChunkedSequence::empty() const
+{
+    return m_size == 0;
+}
+/*!
+  Returns the number of values of each chunk. The last chunk may be shorter.
+*/
+ChunkedSequence::size_type ChunkedSequence::chunkSize() const
+{
+    return m_chunkSize;
+}
+/*!
+  Returns the number of chunks.
+*/
+ChunkedSequence::size_type ChunkedSequence::chunkCount() const
+{
+    return (m_size + m_chunkSize - 1) / m_chunkSize;
+}
+/*!
+  Returns the maximum number of chunks kept in memory.
+*/
+ChunkedSequence::size_type ChunkedSequence::residentChunks() const
+{
+    return m_residentChunks;
+}
+/*!
+  Returns the chunk at \a index, loading it if it isn't resident.
+  \note HilbertIndexOutOfRange() exception is thrown if the given index isn't valid.
+*/
+DataView ChunkedSequence::chunk(size_type index) const
+{
+    if(index >= chunkCount ())
+        throw HilbertIndexOutOfRange();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto cached = m_cache.find (index);
+        if(cached != m_cache.end ())
+        {
+            m_resident.splice (m_resident.begin (), m_resident, cached->second);
+            return cached->second->second;
+        }
+    }
+
+    // Loading outside the lock so other chunks can be used meanwhile
+    DataView view = load (index);
+    readAhead (index + 1);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_cache.find (index) == m_cache.end ())
+    {
+        m_resident.push_front (std::make_pair(index, view));
+        m_cache[index] = m_resident.begin ();
+        while(m_resident.size () > m_residentChunks)
+        {
+            m_cache.erase (m_resident.back ().first);
+            m_resident.pop_back ();
+        }
+    }
+    return view;
+}
+/*!
+  Returns a view of \a count values starting at \a offset. The values are only
+  copied when the range spans more than one chunk.
+  \note HilbertIndexOutOfRange() exception is thrown if the range isn't inside the sequence.
+*/
+DataView ChunkedSequence::range(size_type offset, size_type count) const
+{
+    if(offset > m_size || count > m_size - offset)
+        throw HilbertIndexOutOfRange();
+    if(count == 0)
+        return DataView();
+
+    size_type first = offset / m_chunkSize;
+    if(first == (offset + count - 1) / m_chunkSize)
+        return chunk (first).subview (offset - first * m_chunkSize, count);
+
+    DataSequence values;
+    try
+    {
+        values.reserve (count);
+    }
+    catch (std::bad_alloc& ba)
+    {
+        throw HilbertBadAlloc();
+    }
+    forEachChunk (offset, count, [&](size_type, const DataView &part)
+    {
+        values.insert (values.end (), part.begin (), part.end ());
+    });
+    return DataView::fromSequence (std::move(values));
+}
+/*!
+  Returns the value at \a index.
+  \note HilbertIndexOutOfRange() exception is thrown if the given index isn't valid.
+*/
+hfloat ChunkedSequence::at(size_type index) const
+{
+    if(index >= m_size)
+        throw HilbertIndexOutOfRange();
+    return chunk (index / m_chunkSize)[index % m_chunkSize];
+}
+/*!
+  Calls \a function for each chunk in order, with the position of its first
+  value and a view of its values.
+*/
+void ChunkedSequence::forEachChunk(const ChunkFunction &function) const
+{
+    forEachChunk (0, m_size, function);
+}
+/*!
+  \overload forEachChunk()
+
+  Calls \a function in order for the parts of the chunks holding the \a count
+  values starting at \a offset.
+  \note HilbertIndexOutOfRange() exception is thrown if the range isn't inside the sequence.
+*/
+void ChunkedSequence::forEachChunk(size_type offset, size_type count, const ChunkFunction &function) const
+{
+    if(offset > m_size || count > m_size - offset)
+        throw HilbertIndexOutOfRange();
+    size_type end = offset + count;
+    while(offset < end)
+    {
+        size_type index = offset / m_chunkSize;
+        size_type begin = offset - index * m_chunkSize;
+        DataView values = chunk (index);
+        size_type lenght = std::min(values.size () - begin, end - offset);
+        function (offset, values.subview (begin, lenght));
+        offset += lenght;
+    }
+}
+/*!
+  \brief Compute the count, minimum, maximum, mean and standard deviation of the values.
+
+  The values are read once. The chunk statistics are merged with the
+  pairwise update of Chan et al., which keeps the variance accurate for
+  long sequences.
+*/
+ChunkedSequence::Summary ChunkedSequence::summary() const
+{
+    Summary summary = {0, 0, 0, 0, 0};
+    hfloat m2 = 0;
+    forEachChunk ([&](size_type, const DataView &values)
+    {
+        hfloat sum = 0;
+        hfloat min = values[0];
+        hfloat max = values[0];
+        for(hfloat value : values)
+        {
+            sum += value;
+            min = std::min(min, value);
+            max = std::max(max, value);
+        }
+        hfloat n = values.size ();
+        hfloat mean = sum / n;
+        hfloat chunkM2 = 0;
+        for(hfloat value : values)
+            chunkM2 += (value - mean) * (value - mean);
+
+        if(summary.count == 0)
+        {
+            summary.min = min;
+            summary.max = max;
+        }
+        else
+        {
+            summary.min = std::min(summary.min, min);
+            summary.max = std::max(summary.max, max);
+        }
+        hfloat total = summary.count + n;
+        hfloat delta = mean - summary.mean;
+        m2 += chunkM2 + delta * delta * summary.count * n / total;
+        summary.mean += delta * n / total;
+        summary.count += values.size ();
+    });
+    if(summary.count > 1)
+        summary.stdDeviation = std::sqrt(m2 / hfloat(summary.count - 1));
+    return summary;
+}
+/*!
+  \brief Compute the Shannon entropy of the data.
+
+  Gives the same result as DataSequence::Entropy() reading the file twice, once
+  for the range of the values and once for their histogram.
+*/
+hfloat ChunkedSequence::Entropy() const
+{
+    if(m_size == 0)
+        throw HilbertBadSize();
+
+    Summary range = summary ();
+    std::vector<unsigned long> freq;
+    try
+    {
+        freq.assign (ENTROPY_LEVELS, 0);
+    } catch  (std::bad_alloc& ba)
+    {
+        throw HilbertBadAlloc();
+    }
+
+    hfloat scale = range.max == range.min ? 0 : ENTROPY_LEVELS / (range.max - range.min);
+    hint last = ENTROPY_LEVELS - 1;
+    forEachChunk ([&](size_type, const DataView &values)
+    {
+        for(hfloat value : values)
+        {
+            hint symbol = static_cast<hint>((value - range.min) * scale);
+            freq[symbol < last ? symbol : last]++;
+        }
+    });
+
+    hfloat val=0;
+    int nbins = 0;
+    for(auto instance : freq)
+    {
+        nbins += instance != 0;
+        val=val+instance*zlog(instance);
+    }
+    nbins += nbins == 1;
+    return (-val/m_size+zlog(m_size))/std::log(nbins);
+}
+/*!
+  \brief Compute granularity \a n on data.
+
+  Streams the same values as DataSequence::granularity() would give, each block
+  of \a n values replaced by its mean, to \a output in parts of at most
+  chunkSize() values.
+  \note HilbertBadOperation exception is thrown if \a n is zero or greather than half the size.
+*/
+void ChunkedSequence::granularity(unsigned int n, const ChunkFunction &output) const
+{
+    if(n == 0 || n > m_size / 2)
+        throw HilbertBadOperation();
+
+    size_type blocksEnd = m_size / n * n;
+    size_type written = 0;
+    DataSequence buffer;
+    buffer.reserve (m_chunkSize);
+    auto emit = [&](hfloat value)
+    {
+        buffer.push_back (value);
+        if(buffer.size () == m_chunkSize)
+        {
+            output (written, DataView(buffer));
+            written += buffer.size ();
+            buffer.clear ();
+        }
+    };
+
+    hfloat sum = 0;
+    unsigned int count = 0;
+    forEachChunk ([&](size_type offset, const DataView &values)
+    {
+        for(size_type i = 0; i < values.size (); ++i)
+        {
+            if(offset + i >= blocksEnd) // last values are not averaged
+            {
+                emit (values[i]);
+                continue;
+            }
+            sum += values[i];
+            if(++count == n)
+            {
+                for(unsigned int j = 0; j < n; ++j)
+                    emit (sum / hfloat(n));
+                sum = 0;
+                count = 0;
+            }
+        }
+    });
+    if(!buffer.empty ())
+        output (written, DataView(buffer));
+}
+/*!
+  \brief Generate the image of the data plotted on a HilbertCurve.
+
+  Returns a \a width x \a height HImage with values normalized in range [0-1],
+  laid out by the curve of \a type that a HilbertPlot of the same size would
+  use. If \a width or \a height are zero best dimensions are computed. When
+  there are more values than cells, each cell summarizes a block of
+  consecutive values as given by \a aggregation, with the same blocks as
+  HilbertPlot::aggregate(); otherwise missing cells are zero. Only the image
+  and the resident chunks are held in memory.
+*/
+HImage ChunkedSequence::generateImage(hsize width, hsize height, HilbertCurve::CurveType type,
+                                      HilbertPlot::AggregationMode aggregation) const
+{
+    hsize lenght = m_size > std::numeric_limits<hsize>::max () ? std::numeric_limits<hsize>::max () : m_size;
+    HilbertCurve curve = HilbertPlot::constructCurve (lenght, width, height, type);
+    HImage image;
+    try
+    {
+        image.assign (width, std::vector<hfloat>(height, 0));
+    }
+    catch (std::bad_alloc& ba)
+    {
+        throw HilbertBadAlloc();
+    }
+    size_type cells = static_cast<size_type>(width) * height;
+    if(cells == 0)
+        return image;
+
+    // Truncate reads only the values that fit
+    size_type used = aggregation == HilbertPlot::Truncate ? std::min(m_size, cells) : m_size;
+    size_type cell = 0;
+    size_type end = HilbertPlot::aggregateBlock (used, cells, 0).second;
+    HilbertPlot::BlockAccumulator block;
+    forEachChunk (0, used, [&](size_type offset, const DataView &values)
+    {
+        for(size_type i = 0; i < values.size () && cell < cells; ++i)
+        {
+            block.add (values[i]);
+            if(offset + i + 1 == end)
+            {
+                const HPoint &point = curve[cell];
+                image[point.X ()][point.Y ()] = block.value (aggregation);
+                block = HilbertPlot::BlockAccumulator();
+                if(++cell < cells)
+                    end = HilbertPlot::aggregateBlock (used, cells, cell).second;
+            }
+        }
+    });
+
+    hfloat min = std::numeric_limits<hfloat>::max ();
+    hfloat max = std::numeric_limits<hfloat>::lowest ();
+    for(const auto &column : image)
+    {
+        for(hfloat value : column)
+        {
+            min = std::min(min, value);
+            max = std::max(max, value);
+        }
+    }
+    hfloat minmax = max == min ? 0.0 : 1.0 / (max - min);
+    for(auto &column : image)
+        for(hfloat &value : column)
+            value = (value - min) * minmax;
+    return image;
+}
+
+DataView ChunkedSequence::load(size_type index) const
+{
+    std::size_t sample = BinaryLoader::sampleSize (m_type);
+    size_type first = index * m_chunkSize;
+    std::size_t bytes = std::min(m_chunkSize, m_size - first) * sample;
+    std::shared_ptr<MappedFile> window = std::make_shared<MappedFile>(m_path, m_offset + first * sample, bytes);
+    window->advise (0, bytes, MappedFile::Sequential);
+    return BinaryLoader::fromRaw (window->data (), bytes, m_type, m_order, window);
+}
+
+void ChunkedSequence::readAhead(size_type index) const
+{
+    if(index >= chunkCount ())
+        return;
+    std::size_t sample = BinaryLoader::sampleSize (m_type);
+    size_type first = index * m_chunkSize;
+    std::size_t bytes = std::min(m_chunkSize, m_size - first) * sample;
+    MappedFile::adviseFile (m_path, m_offset + first * sample, bytes, MappedFile::WillNeed);
+}
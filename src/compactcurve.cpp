@@ -0,0 +1,464 @@
+/*!
+   \headerfile "compactcurve.h"
+
+   \title Compact Curve Declaration
+
+   \brief The "compactcurve.h" header define CompactCurve class
+ */
+#include "compactcurve.h"
+#include <algorithm>
+#include "parallel_algorithm.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+const std::size_t DECODE_BLOCK_SIZE = 4096;
+
+// Unit steps, indexed by their 2 bits code.
+const int STEP_X[4] = {1, 0, -1, 0};
+const int STEP_Y[4] = {0, 1, 0, -1};
+
+// Offsets of the 4 points reached by the 4 steps packed in each byte, from
+// the point before them, so a whole byte decodes with two vector additions.
+struct StepTable
+{
+    int32_t x[256][4];
+    int32_t y[256][4];
+
+    StepTable()
+    {
+        for(unsigned byte = 0; byte < 256; ++byte)
+        {
+            int32_t dx = 0;
+            int32_t dy = 0;
+            for(unsigned k = 0; k < 4; ++k)
+            {
+                unsigned code = (byte >> (2 * k)) & 3;
+                dx += STEP_X[code];
+                dy += STEP_Y[code];
+                x[byte][k] = dx;
+                y[byte][k] = dy;
+            }
+        }
+    }
+};
+
+const StepTable &stepTable()
+{
+    static const StepTable table;
+    return table;
+}
+
+unsigned stepCode(const std::vector<uint8_t> &steps, std::size_t step)
+{
+    return (steps[step / 4] >> (2 * (step % 4))) & 3;
+}
+
+void storeFour(hint *output, hint base, const int32_t *offsets)
+{
+#ifdef __SSE2__
+    __m128i values = _mm_add_epi32(_mm_set1_epi32(int(base)),
+                                   _mm_loadu_si128(reinterpret_cast<const __m128i *>(offsets)));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(output), values);
+#else
+    for(unsigned k = 0; k < 4; ++k)
+        output[k] = base + hint(offsets[k]);
+#endif
+}
+}
+
+/*!
+   \class CompactCurve
+   \inmodule hilbertlib
+   \ingroup hcurve
+   \brief The \c CompactCurve class stores a HilbertCurve as a chain code.
+
+   Consecutive points of a curve differ by a unit step, so instead of a
+   HPoint per point the curve is stored as 2 bits per step, plus the
+   coordinates of every checkpointInterval() point. Steps that aren't unit
+   steps are kept apart, with the coordinates they lead to, so any sequence
+   of points can be stored. A curve of a million points takes about 250 KB
+   instead of 24 MB.
+
+   Points are decoded sequentially in constant amortized time with
+   const_iterator or decode(), which decodes the 4 steps of each byte at
+   once. Random access with operator[]() walks at most checkpointInterval()
+   steps from the previous checkpoint.
+
+   Only the coordinates are kept; toCurve() rebuilds the HilbertCurve,
+   including its difference map, to construct plots from it.
+
+   \sa CurveCache
+*/
+
+/*!
+   \class CompactCurve::const_iterator
+   \brief The \c CompactCurve::const_iterator class decodes the points of a
+   CompactCurve in order.
+*/
+
+/*!
+  Constructs an iterator not pointing to any curve.
+ */
+CompactCurve::const_iterator::const_iterator():
+    m_curve(nullptr),
+    m_index(0),
+    m_jump(0)
+{}
+
+CompactCurve::const_iterator::const_iterator(const CompactCurve *curve, std::size_t index):
+    m_curve(curve),
+    m_index(index),
+    m_jump(0)
+{
+    if(index < curve->m_lenght)
+    {
+        hint x, y;
+        curve->locate (index, x, y);
+        m_point = HPoint(x, y);
+        m_jump = curve->jumpAfter (index) - curve->m_jumps.begin ();
+    }
+}
+/*!
+  Returns the current point.
+ */
+const HPoint &CompactCurve::const_iterator::operator*() const
+{
+    return m_point;
+}
+/*!
+  Returns a pointer to the current point.
+ */
+const HPoint *CompactCurve::const_iterator::operator->() const
+{
+    return &m_point;
+}
+/*!
+  Advances to the next point and returns this iterator.
+ */
+CompactCurve::const_iterator &CompactCurve::const_iterator::operator++()
+{
+    if(++m_index < m_curve->m_lenght)
+    {
+        const std::vector<Jump> &jumps = m_curve->m_jumps;
+        if(m_jump < jumps.size () && jumps[m_jump].index == m_index)
+        {
+            m_point = HPoint(jumps[m_jump].x, jumps[m_jump].y);
+            ++m_jump;
+        }
+        else
+        {
+            unsigned code = stepCode (m_curve->m_steps, m_index - 1);
+            m_point.X (m_point.X () + STEP_X[code]);
+            m_point.Y (m_point.Y () + STEP_Y[code]);
+        }
+    }
+    return *this;
+}
+/*!
+  Advances to the next point and returns the previous iterator.
+ */
+CompactCurve::const_iterator CompactCurve::const_iterator::operator++(int)
+{
+    const_iterator previous = *this;
+    ++*this;
+    return previous;
+}
+/*!
+  Returns \c true if this iterator and \a other point to the same point.
+ */
+bool CompactCurve::const_iterator::operator==(const const_iterator &other) const
+{
+    return m_curve == other.m_curve && m_index == other.m_index;
+}
+/*!
+  Returns \c true if this iterator and \a other point to different points.
+ */
+bool CompactCurve::const_iterator::operator!=(const const_iterator &other) const
+{
+    return !(*this == other);
+}
+
+/*!
+  Constructs an empty curve.
+ */
+CompactCurve::CompactCurve():
+    m_width(0),
+    m_height(0),
+    m_type(HilbertCurve::H0),
+    m_difference(false),
+    m_meanDifference(0),
+    m_lenght(0),
+    m_interval(DEFAULT_CHECKPOINT_INTERVAL)
+{}
+/*!
+  Constructs the compact form of \a curve, keeping the coordinates of every
+  \a checkpointInterval point for random access.
+ */
+CompactCurve::CompactCurve(const HilbertCurve &curve, std::size_t checkpointInterval):
+    m_width(curve.width ()),
+    m_height(curve.height ()),
+    m_type(curve.type ()),
+    m_difference(curve.lenght () > 1 && curve[1].index == 1),
+    m_meanDifference(m_difference ? curve.meanDifference () : 0),
+    m_lenght(curve.lenght ()),
+    m_interval(std::max<std::size_t>(checkpointInterval, 1))
+{
+    try
+    {
+        m_steps.assign ((std::max<std::size_t>(m_lenght, 1) + 2) / 4, 0);
+        m_checkpoints.reserve (2 * ((m_lenght + m_interval - 1) / m_interval));
+        for(std::size_t i = 0; i < m_lenght; ++i)
+        {
+            const HPoint &point = curve[i];
+            if(i % m_interval == 0)
+            {
+                m_checkpoints.push_back (point.X ());
+                m_checkpoints.push_back (point.Y ());
+            }
+            if(i == 0)
+                continue;
+            long long dx = (long long)point.X () - curve[i - 1].X ();
+            long long dy = (long long)point.Y () - curve[i - 1].Y ();
+            unsigned code = 0;
+            if(dx == 0 && dy == 1)
+                code = 1;
+            else if(dx == -1 && dy == 0)
+                code = 2;
+            else if(dx == 0 && dy == -1)
+                code = 3;
+            else if(dx != 1 || dy != 0)
+                m_jumps.push_back (Jump{i, point.X (), point.Y ()});
+            m_steps[(i - 1) / 4] |= uint8_t(code << (2 * ((i - 1) % 4)));
+        }
+    }
+    catch (std::bad_alloc& ba)
+    {
+        throw HilbertBadAlloc();
+    }
+}
+/*!
+  Returns the number of points of the curve.
+ */
+hsize CompactCurve::lenght() const
+{
+    return hsize(m_lenght);
+}
+/*!
+  Returns the width of the curve.
+ */
+hsize CompactCurve::width() const
+{
+    return m_width;
+}
+/*!
+  Returns the height of the curve.
+ */
+hsize CompactCurve::height() const
+{
+    return m_height;
+}
+/*!
+  Returns the type of the curve.
+ */
+HilbertCurve::CurveType CompactCurve::type() const
+{
+    return m_type;
+}
+/*!
+  Returns the mean difference of the curve, or zero if it was built without
+  difference map.
+ */
+hfloat CompactCurve::meanDifference() const
+{
+    return m_meanDifference;
+}
+/*!
+  Returns the number of points between checkpoints.
+ */
+std::size_t CompactCurve::checkpointInterval() const
+{
+    return m_interval;
+}
+/*!
+  Returns the number of steps that aren't unit steps, zero for the curves
+  built by HilbertCurve.
+ */
+std::size_t CompactCurve::jumps() const
+{
+    return m_jumps.size ();
+}
+/*!
+  Returns the bytes taken by the curve.
+ */
+std::size_t CompactCurve::memoryUsage() const
+{
+    return sizeof(*this) + m_steps.capacity () + m_checkpoints.capacity () * sizeof(hint) +
+           m_jumps.capacity () * sizeof(Jump);
+}
+/*!
+  Returns the point at \a index, with zero index and difference values.
+  \note HilbertIndexOutOfRange() exception is thrown if the given index isn't valid.
+ */
+HPoint CompactCurve::operator[](std::size_t index) const
+{
+    if(index >= m_lenght)
+        throw HilbertIndexOutOfRange();
+    hint x, y;
+    locate (index, x, y);
+    return HPoint(x, y);
+}
+/*!
+  Writes the coordinates of the \a count points from \a first into \a x and
+  \a y.
+  \note HilbertIndexOutOfRange() exception is thrown if the points aren't in the curve.
+ */
+void CompactCurve::decode(std::size_t first, std::size_t count, hint *x, hint *y) const
+{
+    if(first > m_lenght || count > m_lenght - first)
+        throw HilbertIndexOutOfRange();
+    if(count == 0)
+        return;
+
+    const StepTable &table = stepTable ();
+    hint px, py;
+    locate (first, px, py);
+    x[0] = px;
+    y[0] = py;
+    std::vector<Jump>::const_iterator jump = jumpAfter (first);
+    std::size_t i = first;
+    for(std::size_t out = 1; out < count; )
+    {
+        // Step i leads from point i to point i + 1.
+        if(i % 4 == 0 && count - out >= 4 && (jump == m_jumps.end () || jump->index > i + 4))
+        {
+            uint8_t byte = m_steps[i / 4];
+            storeFour (x + out, px, table.x[byte]);
+            storeFour (y + out, py, table.y[byte]);
+            px += table.x[byte][3];
+            py += table.y[byte][3];
+            i += 4;
+            out += 4;
+            continue;
+        }
+        if(jump != m_jumps.end () && jump->index == i + 1)
+        {
+            px = jump->x;
+            py = jump->y;
+            ++jump;
+        }
+        else
+        {
+            unsigned code = stepCode (m_steps, i);
+            px += STEP_X[code];
+            py += STEP_Y[code];
+        }
+        x[out] = px;
+        y[out] = py;
+        ++i;
+        ++out;
+    }
+}
+/*!
+  Returns an iterator to the first point.
+ */
+CompactCurve::const_iterator CompactCurve::begin() const
+{
+    return const_iterator(this, 0);
+}
+/*!
+  Returns an iterator past the last point.
+ */
+CompactCurve::const_iterator CompactCurve::end() const
+{
+    return const_iterator(this, m_lenght);
+}
+/*!
+  Returns the HilbertCurve stored, with its difference map if it had one.
+  Points are decoded in parallel from the checkpoints.
+ */
+HilbertCurve CompactCurve::toCurve() const
+{
+    HilbertCurve curve;
+    curve.n = m_height;
+    curve.m = m_width;
+    curve.m_type = m_type;
+    curve.m_mean_difference = m_meanDifference;
+    try
+    {
+        curve.m_curve.assign (m_lenght, HPoint());
+    }
+    catch (std::bad_alloc& ba)
+    {
+        throw HilbertBadAlloc();
+    }
+    std::vector<HPoint> &points = curve.m_curve;
+    for_each_chunk_parallel (m_lenght, parallel_chunk_count (m_lenght, 16 * DECODE_BLOCK_SIZE),
+                             [&](unsigned long, unsigned long begin, unsigned long end)
+    {
+        std::vector<hint> x(DECODE_BLOCK_SIZE);
+        std::vector<hint> y(DECODE_BLOCK_SIZE);
+        for(std::size_t block = begin; block < end; block += DECODE_BLOCK_SIZE)
+        {
+            std::size_t count = std::min<std::size_t>(end - block, DECODE_BLOCK_SIZE);
+            decode (block, count, x.data (), y.data ());
+            for(std::size_t k = 0; k < count; ++k)
+                points[block + k] = HPoint(x[k], y[k]);
+        }
+    });
+    if(m_difference)
+    {
+        // The stored curve is already reflected, which leaves the difference
+        // of every point unchanged; only the running mean could round apart.
+        curve.BuildDifference ();
+        curve.m_mean_difference = m_meanDifference;
+    }
+    return curve;
+}
+
+// Sets x, y to the point at index, walking from the checkpoint before it.
+void CompactCurve::locate(std::size_t index, hint &x, hint &y) const
+{
+    const StepTable &table = stepTable ();
+    std::size_t checkpoint = index / m_interval;
+    std::size_t i = checkpoint * m_interval;
+    x = m_checkpoints[2 * checkpoint];
+    y = m_checkpoints[2 * checkpoint + 1];
+    std::vector<Jump>::const_iterator jump = jumpAfter (i);
+    while(i < index)
+    {
+        if(i % 4 == 0 && index - i >= 4 && (jump == m_jumps.end () || jump->index > i + 4))
+        {
+            uint8_t byte = m_steps[i / 4];
+            x += table.x[byte][3];
+            y += table.y[byte][3];
+            i += 4;
+            continue;
+        }
+        if(jump != m_jumps.end () && jump->index == i + 1)
+        {
+            x = jump->x;
+            y = jump->y;
+            ++jump;
+        }
+        else
+        {
+            unsigned code = stepCode (m_steps, i);
+            x += STEP_X[code];
+            y += STEP_Y[code];
+        }
+        ++i;
+    }
+}
+
+// Returns the first jump leading to a point after index.
+std::vector<CompactCurve::Jump>::const_iterator CompactCurve::jumpAfter(std::size_t index) const
+{
+    return std::upper_bound(m_jumps.begin (), m_jumps.end (), index, [](std::size_t value, const Jump &jump)
+    {
+        return value < jump.index;
+    });
+}
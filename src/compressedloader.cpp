@@ -0,0 +1,506 @@
+/*!
+   \headerfile "compressedloader.h"
+
+   \title Compressed Loader Declaration
+
+   \brief The "compressedloader.h" header define CompressedLoader class
+ */
+#include "compressedloader.h"
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef HILBERT_HAS_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HILBERT_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+#include "numberparser.h"
+#include "threads_utility.h"
+
+namespace
+{
+// Size of the compressed input reads.
+const std::size_t INPUT_BUFFER_SIZE = 1 << 20;
+
+// Sequential source of decompressed bytes.
+class Decoder
+{
+    public:
+        virtual ~Decoder() {}
+        // Fills buffer with up to size bytes. Returns less than size only at the end.
+        virtual std::size_t read(char *buffer, std::size_t size) = 0;
+};
+
+class PlainDecoder : public Decoder
+{
+    public:
+        explicit PlainDecoder(const std::string &path):
+            m_input(path.c_str (), std::ios::binary)
+        {
+            if(!m_input)
+                throw HilbertIOError();
+        }
+        std::size_t read(char *buffer, std::size_t size)
+        {
+            m_input.read (buffer, size);
+            return m_input.gcount ();
+        }
+    private:
+        std::ifstream m_input;
+};
+
+#ifdef HILBERT_HAS_ZLIB
+class GzipDecoder : public Decoder
+{
+    public:
+        explicit GzipDecoder(const std::string &path):
+            m_input(path.c_str (), std::ios::binary), m_buffer(INPUT_BUFFER_SIZE),
+            m_memberEnded(false), m_end(false)
+        {
+            if(!m_input)
+                throw HilbertIOError();
+            m_stream.zalloc = Z_NULL;
+            m_stream.zfree = Z_NULL;
+            m_stream.opaque = Z_NULL;
+            m_stream.next_in = Z_NULL;
+            m_stream.avail_in = 0;
+            // 15 window bits, +32 to accept both gzip and zlib headers
+            if(inflateInit2(&m_stream, 15 + 32) != Z_OK)
+                throw HilbertBadAlloc();
+        }
+        ~GzipDecoder()
+        {
+            inflateEnd(&m_stream);
+        }
+        std::size_t read(char *buffer, std::size_t size)
+        {
+            m_stream.next_out = reinterpret_cast<Bytef *>(buffer);
+            m_stream.avail_out = size;
+            while(m_stream.avail_out > 0 && !m_end)
+            {
+                if(m_stream.avail_in == 0)
+                {
+                    m_input.read (m_buffer.data (), m_buffer.size ());
+                    m_stream.next_in = reinterpret_cast<Bytef *>(m_buffer.data ());
+                    m_stream.avail_in = m_input.gcount ();
+                    if(m_stream.avail_in == 0)
+                    {
+                        if(!m_memberEnded) // truncated stream
+                            throw HilbertIOError();
+                        m_end = true;
+                        break;
+                    }
+                }
+                int status = inflate(&m_stream, Z_NO_FLUSH);
+                if(status == Z_STREAM_END)
+                {
+                    // Concatenated gzip members are read as one stream
+                    m_memberEnded = true;
+                    inflateReset(&m_stream);
+                }
+                else if(status == Z_OK || status == Z_BUF_ERROR)
+                {
+                    m_memberEnded = false;
+                }
+                else
+                {
+                    throw HilbertIOError();
+                }
+            }
+            return size - m_stream.avail_out;
+        }
+    private:
+        std::ifstream m_input;
+        std::vector<char> m_buffer;
+        z_stream m_stream;
+        bool m_memberEnded;
+        bool m_end;
+};
+#endif
+
+#ifdef HILBERT_HAS_ZSTD
+class ZstdDecoder : public Decoder
+{
+    public:
+        explicit ZstdDecoder(const std::string &path):
+            m_input(path.c_str (), std::ios::binary), m_buffer(ZSTD_DStreamInSize()),
+            m_stream(ZSTD_createDStream()), m_frameEnded(true), m_eof(false)
+        {
+            if(!m_input)
+            {
+                ZSTD_freeDStream(m_stream);
+                throw HilbertIOError();
+            }
+            if(m_stream == nullptr)
+                throw HilbertBadAlloc();
+            ZSTD_initDStream(m_stream);
+            m_in.src = m_buffer.data ();
+            m_in.size = 0;
+            m_in.pos = 0;
+        }
+        ~ZstdDecoder()
+        {
+            ZSTD_freeDStream(m_stream);
+        }
+        std::size_t read(char *buffer, std::size_t size)
+        {
+            ZSTD_outBuffer out = {buffer, size, 0};
+            while(out.pos < size)
+            {
+                if(m_in.pos == m_in.size && !m_eof)
+                {
+                    m_input.read (m_buffer.data (), m_buffer.size ());
+                    m_in.size = m_input.gcount ();
+                    m_in.pos = 0;
+                    m_eof = m_in.size == 0;
+                }
+                std::size_t produced = out.pos;
+                std::size_t status = ZSTD_decompressStream(m_stream, &out, &m_in);
+                if(ZSTD_isError(status))
+                    throw HilbertIOError();
+                m_frameEnded = status == 0;
+                // At the end of the input, stop once the decoder is flushed
+                if(m_eof && out.pos == produced)
+                {
+                    if(!m_frameEnded)
+                        throw HilbertIOError();
+                    break;
+                }
+            }
+            return out.pos;
+        }
+    private:
+        std::ifstream m_input;
+        std::vector<char> m_buffer;
+        ZSTD_DStream *m_stream;
+        ZSTD_inBuffer m_in;
+        bool m_frameEnded;
+        bool m_eof;
+};
+#endif
+
+std::unique_ptr<Decoder> openDecoder(const std::string &path, CompressedLoader::Compression compression)
+{
+    if(compression == CompressedLoader::Auto)
+        compression = CompressedLoader::detect (path);
+    if(!CompressedLoader::isSupported (compression))
+        throw HilbertBadOperation();
+    switch (compression)
+    {
+#ifdef HILBERT_HAS_ZLIB
+        case CompressedLoader::Gzip: return std::unique_ptr<Decoder>(new GzipDecoder(path));
+#endif
+#ifdef HILBERT_HAS_ZSTD
+        case CompressedLoader::Zstd: return std::unique_ptr<Decoder>(new ZstdDecoder(path));
+#endif
+        default: return std::unique_ptr<Decoder>(new PlainDecoder(path));
+    }
+}
+
+struct Block
+{
+    std::size_t id;
+    std::vector<char> data;
+};
+
+// Returns how many of the size bytes at data form complete items; the rest is
+// carried to the next block. last is set for the final block.
+typedef std::function<std::size_t(const char *data, std::size_t size, bool last)> SplitFunction;
+typedef std::function<DataView(const std::vector<char> &data)> ParseFunction;
+
+// Decompresses on the calling thread into blocks that a bounded queue hands to
+// parser threads. Parsed blocks are passed to output in input order.
+std::size_t runPipeline(Decoder &decoder, const SplitFunction &split, const ParseFunction &parse,
+                        const CompressedLoader::BlockFunction &output)
+{
+    unsigned int hardware_threads = std::thread::hardware_concurrency ();
+    unsigned int workers = hardware_threads > 1 ? hardware_threads - 1 : 1;
+    bounded_queue<Block> queue(2 * workers);
+
+    std::mutex mutex;
+    std::condition_variable turn;
+    std::size_t next = 0;
+    std::size_t count = 0;
+    bool failed = false;
+    std::exception_ptr error;
+    auto fail = [&](std::exception_ptr exception)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if(!failed)
+                error = exception;
+            failed = true;
+        }
+        turn.notify_all ();
+        queue.close ();
+    };
+
+    auto worker = [&]()
+    {
+        Block block;
+        while(queue.pop (block))
+        {
+            try
+            {
+                DataView values = parse (block.data);
+                std::unique_lock<std::mutex> lock(mutex);
+                turn.wait (lock, [&]{ return failed || next == block.id; });
+                if(failed)
+                    continue;
+                output (count, values);
+                count += values.size ();
+                ++next;
+                turn.notify_all ();
+            }
+            catch (...)
+            {
+                fail (std::current_exception());
+            }
+        }
+    };
+    std::vector<std::future<void>> futures;
+    for(unsigned int w = 0; w < workers; ++w)
+        futures.push_back (std::async(std::launch::async, worker));
+
+    try
+    {
+        std::vector<char> carry;
+        for(std::size_t id = 0; ; )
+        {
+            std::vector<char> data;
+            data.reserve (carry.size () + PIPELINE_BLOCK_SIZE);
+            data.assign (carry.begin (), carry.end ());
+            data.resize (carry.size () + PIPELINE_BLOCK_SIZE);
+            std::size_t read = decoder.read (data.data () + carry.size (), PIPELINE_BLOCK_SIZE);
+            bool last = read < PIPELINE_BLOCK_SIZE;
+            data.resize (carry.size () + read);
+
+            std::size_t keep = split (data.data (), data.size (), last);
+            carry.assign (data.begin () + keep, data.end ());
+            data.resize (keep);
+            if(!data.empty () && !queue.push (Block{id++, std::move(data)}))
+                break;
+            if(last)
+                break;
+        }
+    }
+    catch (std::bad_alloc& ba)
+    {
+        fail (std::make_exception_ptr(HilbertBadAlloc()));
+    }
+    catch (...)
+    {
+        fail (std::current_exception());
+    }
+    queue.close ();
+    for(auto &future : futures)
+        future.get ();
+    if(error)
+        std::rethrow_exception(error);
+    return count;
+}
+
+std::size_t textSplit(const char *data, std::size_t size, bool last)
+{
+    if(last)
+        return size;
+    while(size > 0 && !NumberParser::isSeparator (data[size - 1]))
+        --size;
+    return size;
+}
+
+DataView textParse(const std::vector<char> &data)
+{
+    DataSequence values;
+    values.reserve (data.size () / 8);
+    NumberParser::parse (data.data (), data.data () + data.size (), values);
+    return DataView::fromSequence (std::move(values));
+}
+}
+
+/*!
+   \class CompressedLoader
+   \inmodule hilbertlib
+   \ingroup hdata
+   \brief The \c CompressedLoader class loads gzip or zstd compressed captures
+   without decompressing them to disk.
+
+   Loading is a pipeline: the calling thread decompresses the file into blocks
+   of PIPELINE_BLOCK_SIZE bytes, handed through a bounded queue to parser
+   threads, one less than the hardware threads. The parsed blocks are then
+   delivered in file order. Blocks are cut at separators for plain text and at
+   sample boundaries for binary data, so the values are the same as loading
+   the decompressed file with DataSequence::fromPlainText() or
+   BinaryLoader::fromRaw(). The queue holds two blocks per parser thread,
+   which bounds the memory used besides the result.
+
+   Results can be collected into a DataSequence, streamed block by block to a
+   function, or written as native \c hfloat samples to a raw file that a
+   ChunkedSequence can open when they don't fit in memory.
+
+   Gzip support requires zlib and zstd support requires libzstd, enabled with
+   the \c HILBERT_HAS_ZLIB and \c HILBERT_HAS_ZSTD definitions. Uncompressed
+   files are always accepted.
+
+   \note HilbertIOError exception is thrown if the file can't be read or is corrupted,
+   and HilbertBadOperation if its compression isn't supported.
+*/
+
+/*!
+  Returns the values of the plain text file at \a path, compressed with
+  \a compression.
+*/
+DataSequence CompressedLoader::fromPlainText(const std::string &path, Compression compression)
+{
+    DataSequence values;
+    streamPlainText (path, [&](std::size_t, const DataView &block)
+    {
+        values.insert (values.end (), block.begin (), block.end ());
+    }, compression);
+    return values;
+}
+/*!
+  Returns the samples of \a type stored with \a order byte order in the binary
+  file at \a path, compressed with \a compression.
+*/
+DataSequence CompressedLoader::fromRaw(const std::string &path, BinaryLoader::SampleType type,
+                                       BinaryLoader::ByteOrder order, Compression compression)
+{
+    DataSequence values;
+    streamRaw (path, type, order, [&](std::size_t, const DataView &block)
+    {
+        values.insert (values.end (), block.begin (), block.end ());
+    }, compression);
+    return values;
+}
+/*!
+  \brief Parse a compressed plain text file block by block.
+
+  Calls \a output in order with the position of the first value of each block
+  and its values. Returns the amount of values.
+*/
+std::size_t CompressedLoader::streamPlainText(const std::string &path, const BlockFunction &output,
+                                              Compression compression)
+{
+    std::unique_ptr<Decoder> decoder = openDecoder (path, compression);
+    return runPipeline (*decoder, textSplit, textParse, output);
+}
+/*!
+  \brief Convert a compressed binary file block by block.
+
+  Calls \a output in order with the position of the first sample of each block
+  and its samples of \a type, stored with \a order byte order. Trailing bytes
+  not forming a whole sample are ignored. Returns the amount of samples.
+*/
+std::size_t CompressedLoader::streamRaw(const std::string &path, BinaryLoader::SampleType type,
+                                        BinaryLoader::ByteOrder order, const BlockFunction &output,
+                                        Compression compression)
+{
+    std::size_t sample = BinaryLoader::sampleSize (type);
+    std::unique_ptr<Decoder> decoder = openDecoder (path, compression);
+    return runPipeline (*decoder, [sample](const char *, std::size_t size, bool)
+    {
+        return size / sample * sample;
+    }, [type, order](const std::vector<char> &data)
+    {
+        return BinaryLoader::fromRaw (data.data (), data.size (), type, order);
+    }, output);
+}
+/*!
+  Parses the compressed plain text file at \a path writing its values as native
+  \c hfloat samples to \a rawPath, which can then be opened as a ChunkedSequence.
+  Returns the amount of values.
+*/
+std::size_t CompressedLoader::plainTextToRaw(const std::string &path, const std::string &rawPath,
+                                             Compression compression)
+{
+    std::ofstream raw(rawPath.c_str (), std::ios::binary);
+    if(!raw)
+        throw HilbertIOError();
+    std::size_t count = streamPlainText (path, [&](std::size_t, const DataView &block)
+    {
+        raw.write (reinterpret_cast<const char *>(block.data ()), block.size () * sizeof(hfloat));
+        if(!raw)
+            throw HilbertIOError();
+    }, compression);
+    raw.close ();
+    if(!raw)
+        throw HilbertIOError();
+    return count;
+}
+/*!
+  Decompresses the file at \a path to \a outputPath. Returns the amount of
+  bytes written.
+*/
+std::size_t CompressedLoader::decompress(const std::string &path, const std::string &outputPath,
+                                         Compression compression)
+{
+    std::unique_ptr<Decoder> decoder = openDecoder (path, compression);
+    std::ofstream output(outputPath.c_str (), std::ios::binary);
+    if(!output)
+        throw HilbertIOError();
+    std::vector<char> buffer(PIPELINE_BLOCK_SIZE);
+    std::size_t total = 0;
+    std::size_t read;
+    do
+    {
+        read = decoder->read (buffer.data (), buffer.size ());
+        output.write (buffer.data (), read);
+        total += read;
+    }
+    while(read == buffer.size () && output);
+    output.close ();
+    if(!output)
+        throw HilbertIOError();
+    return total;
+}
+/*!
+  Returns the compression of the file at \a path from its first bytes, None if
+  it isn't gzip nor zstd.
+  \note HilbertIOError exception is thrown if the file can't be opened.
+*/
+CompressedLoader::Compression CompressedLoader::detect(const std::string &path)
+{
+    std::ifstream input(path.c_str (), std::ios::binary);
+    if(!input)
+        throw HilbertIOError();
+    unsigned char magic[4] = {0, 0, 0, 0};
+    input.read (reinterpret_cast<char *>(magic), 4);
+    if(input.gcount () >= 2 && magic[0] == 0x1F && magic[1] == 0x8B)
+        return Gzip;
+    if(input.gcount () == 4 && magic[0] == 0x28 && magic[1] == 0xB5 && magic[2] == 0x2F && magic[3] == 0xFD)
+        return Zstd;
+    return None;
+}
+/*!
+  Returns \c true if files with \a compression can be read by this build.
+*/
+bool CompressedLoader::isSupported(Compression compression)
+{
+    switch (compression)
+    {
+        case Gzip:
+#ifdef HILBERT_HAS_ZLIB
+            return true;
+#else
+            return false;
+#endif
+        case Zstd:
+#ifdef HILBERT_HAS_ZSTD
+            return true;
+#else
+            return false;
+#endif
+        default:
+            return true;
+    }
+}
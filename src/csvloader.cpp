@@ -0,0 +1,407 @@
+/*!
+   \headerfile "csvloader.h"
+
+   \title CSV Loader Declaration
+
+   \brief The "csvloader.h" header define CsvLoader class
+ */
+#include "csvloader.h"
+#include <algorithm>
+#include <cstring>
+
+#include "mappedfile.h"
+#include "numberparser.h"
+#include "parallel_algorithm.h"
+
+namespace
+{
+// Minimum amount of bytes parsed by each thread.
+const std::size_t CSV_CHUNK_SIZE = 1 << 20;
+// Fields longer than this aren't retried with an upper case exponent.
+const std::size_t MAX_NUMBER_LENGHT = 64;
+
+inline bool isBlank(char ch)
+{
+    return ch == ' ' || ch == '\t' || ch == '\r';
+}
+
+// Reads the field starting at p, leaving its contents without quotes in
+// [begin, end). Returns the position after the delimiter or the newline
+// ending the field; lastField is set if the field ends the record.
+const char *nextField(const char *p, const char *last, const CsvLoader::Options &options,
+                      const char *&begin, const char *&end, bool &lastField)
+{
+    const char delimiter = options.delimiter;
+    while(p != last && *p != delimiter && *p != options.quote && *p != '\n' && isBlank (*p))
+        ++p;
+    if(p != last && *p == options.quote)
+    {
+        begin = ++p;
+        while(p != last)
+        {
+            if(*p == options.quote)
+            {
+                if(last - p > 1 && p[1] == options.quote) // escaped quote
+                {
+                    p += 2;
+                    continue;
+                }
+                break;
+            }
+            ++p;
+        }
+        end = p;
+        while(p != last && *p != delimiter && *p != '\n')
+            ++p;
+    }
+    else
+    {
+        begin = p;
+        while(p != last && *p != delimiter && *p != '\n')
+            ++p;
+        end = p;
+    }
+    lastField = p == last || *p == '\n';
+    return p == last ? last : p + 1;
+}
+
+// Returns the number in [begin, end), or missing if the field isn't a number.
+hfloat fieldValue(const char *begin, const char *end, hfloat missing)
+{
+    while(begin != end && isBlank (*begin))
+        ++begin;
+    while(end != begin && isBlank (end[-1]))
+        --end;
+    if(begin == end)
+        return missing;
+
+    hfloat value;
+    bool valid;
+    const char *p = NumberParser::parseNumber (begin, end, value, valid);
+    if(valid && p == end)
+        return value;
+    if(p != end && *p == 'E' && std::size_t(end - begin) <= MAX_NUMBER_LENGHT)
+    {
+        char number[MAX_NUMBER_LENGHT];
+        std::size_t lenght = end - begin;
+        std::memcpy(number, begin, lenght);
+        number[p - begin] = 'e';
+        p = NumberParser::parseNumber (number, number + lenght, value, valid);
+        if(valid && p == number + lenght)
+            return value;
+    }
+    return missing;
+}
+
+// Returns the position after the end of the record starting at p.
+const char *skipRecord(const char *p, const char *last, const CsvLoader::Options &options)
+{
+    const char *begin;
+    const char *end;
+    bool lastField = false;
+    while(!lastField)
+        p = nextField (p, last, options, begin, end, lastField);
+    return p;
+}
+
+// Returns true if the record starting at p has no fields.
+inline bool isEmptyRecord(const char *p, const char *last)
+{
+    while(p != last && *p == '\r')
+        ++p;
+    return p == last || *p == '\n';
+}
+
+// Returns the first position not before position that starts a record, given
+// whether position is inside a quoted field.
+const char *recordBoundary(const char *position, const char *last, char quote, bool quoted)
+{
+    for(; position != last; ++position)
+    {
+        if(*position == quote)
+            quoted = !quoted;
+        else if(*position == '\n' && !quoted)
+            return position + 1;
+    }
+    return last;
+}
+
+// Parses the records in [first, last), appending a value per selected column.
+void parseRecords(const char *first, const char *last, const CsvLoader::Options &options,
+                  const std::vector<int> &slots, std::vector<std::vector<hfloat>> &columns)
+{
+    std::vector<hfloat> row(columns.size ());
+    const char *begin;
+    const char *end;
+    while(first != last)
+    {
+        if(isEmptyRecord (first, last))
+        {
+            first = std::find(first, last, '\n');
+            first += first != last;
+            continue;
+        }
+        std::fill(row.begin (), row.end (), options.missing);
+        bool lastField = false;
+        for(std::size_t field = 0; !lastField; ++field)
+        {
+            first = nextField (first, last, options, begin, end, lastField);
+            if(field < slots.size () && slots[field] >= 0)
+                row[slots[field]] = fieldValue (begin, end, options.missing);
+        }
+        for(std::size_t c = 0; c < row.size (); ++c)
+            columns[c].push_back (row[c]);
+    }
+}
+}
+
+/*!
+   \class CsvLoader
+   \inmodule hilbertlib
+   \ingroup hdata
+   \brief The \c CsvLoader class reads numeric columns of delimited text files.
+
+   CSV, TSV and any other single character delimited file can be read. Fields
+   may be quoted, with doubled quotes inside them, and quoted fields may span
+   several lines. Empty lines are skipped.
+
+   The selected columns are all read in a single pass, each one into its own
+   DataSequence, so a file is parsed only once whatever the amount of columns.
+   Large inputs are split at record boundaries, found by tracking the quoting
+   state, and the parts are parsed concurrently. Numbers are converted with
+   NumberParser.
+
+   Every record gives a value to each selected column: empty fields, fields
+   that aren't numbers and fields missing at the end of short records get
+   Options::missing, NaN by default, so the columns stay aligned.
+*/
+
+/*!
+  \class CsvLoader::Options
+  \inmodule hilbertlib
+  \brief The \c CsvLoader::Options class sets the format of the file.
+
+  \c delimiter separates the fields, \c quote encloses quoted fields,
+  \c header tells if the first record holds the column names and \c missing
+  is the value given to missing fields.
+*/
+
+/*!
+  \class CsvLoader::Table
+  \inmodule hilbertlib
+  \brief The \c CsvLoader::Table class holds the columns read by CsvLoader.
+
+  \c columns holds the values of each selected column, in the order they
+  were selected, and \c names their names if the file has a header.
+*/
+
+/*!
+  Constructs the options for fields separated by \a delimiter, with column
+  names on the first record if \a header is \c true and \a missing as the
+  value of missing fields.
+*/
+CsvLoader::Options::Options(char delimiter, bool header, hfloat missing):
+    delimiter(delimiter), quote('"'), header(header), missing(missing)
+{}
+/*!
+  \brief Read columns of a delimited file.
+
+  Maps the file at \a path and returns the \a columns at the given zero based
+  positions, or all the columns of the first record if \a columns is empty.
+  \a options gives the format of the file.
+  \note HilbertIOError exception is thrown if the file can't be read.
+*/
+CsvLoader::Table CsvLoader::fromFile(const std::string &path, const std::vector<std::size_t> &columns,
+                                     const Options &options)
+{
+    MappedFile file(path);
+    file.advise (0, file.size (), MappedFile::Sequential);
+    return fromText (file.data (), file.data () + file.size (), columns, options);
+}
+/*!
+  \overload fromFile()
+
+  Returns the \a columns with the given names in the header of the file at \a path.
+  \note HilbertBadOperation exception is thrown if a name isn't in the header.
+*/
+CsvLoader::Table CsvLoader::fromFile(const std::string &path, const std::vector<std::string> &columns,
+                                     const Options &options)
+{
+    MappedFile file(path);
+    file.advise (0, file.size (), MappedFile::Sequential);
+    return fromText (file.data (), file.data () + file.size (), columns, options);
+}
+/*!
+  \brief Read columns of delimited text.
+
+  Returns the \a columns at the given zero based positions of the text in
+  [\a first, \a last), or all the columns of the first record if \a columns is
+  empty. \a options gives the format of the text.
+*/
+CsvLoader::Table CsvLoader::fromText(const char *first, const char *last, const std::vector<std::size_t> &columns,
+                                     const Options &options)
+{
+    Table table;
+    std::vector<std::string> header;
+    const char *data = first;
+    if(options.header)
+    {
+        header = readHeader (first, last, options);
+        data = skipRecord (first, last, options);
+    }
+
+    std::vector<std::size_t> selected = columns;
+    if(selected.empty ())
+    {
+        std::size_t count = header.size ();
+        if(!options.header)
+        {
+            const char *begin;
+            const char *end;
+            bool lastField = false;
+            for(const char *p = data; !lastField && p != last; ++count)
+                p = nextField (p, last, options, begin, end, lastField);
+        }
+        for(std::size_t c = 0; c < count; ++c)
+            selected.push_back (c);
+    }
+
+    std::vector<int> slots;
+    for(std::size_t c = 0; c < selected.size (); ++c)
+    {
+        if(selected[c] >= slots.size ())
+            slots.resize (selected[c] + 1, -1);
+        slots[selected[c]] = c;
+        table.names.push_back (selected[c] < header.size () ? header[selected[c]] : std::string());
+    }
+    table.columns.resize (selected.size ());
+
+    // Split points moved forward to the next record start outside quotes
+    std::size_t lenght = last - data;
+    unsigned long chunks = parallel_chunk_count (lenght, CSV_CHUNK_SIZE);
+    std::vector<std::size_t> quotes(chunks, 0);
+    for_each_chunk_parallel (chunks, chunks, [&](unsigned long chunk, unsigned long, unsigned long)
+    {
+        const char *begin = data + lenght / chunks * chunk;
+        const char *end = chunk + 1 == chunks ? last : data + lenght / chunks * (chunk + 1);
+        quotes[chunk] = std::count(begin, end, options.quote);
+    });
+    std::vector<const char *> bounds(chunks + 1, last);
+    bounds[0] = data;
+    std::size_t quoteCount = 0;
+    for(unsigned long c = 1; c < chunks; ++c)
+    {
+        quoteCount += quotes[c - 1];
+        const char *position = data + lenght / chunks * c;
+        bounds[c] = std::max(bounds[c - 1], recordBoundary (position, last, options.quote, quoteCount % 2 == 1));
+    }
+
+    std::vector<std::vector<std::vector<hfloat>>> parsed(chunks, std::vector<std::vector<hfloat>>(selected.size ()));
+    try
+    {
+        for_each_chunk_parallel (chunks, chunks, [&](unsigned long chunk, unsigned long, unsigned long)
+        {
+            parseRecords (bounds[chunk], bounds[chunk + 1], options, slots, parsed[chunk]);
+        });
+    }
+    catch (std::bad_alloc& ba)
+    {
+        throw HilbertBadAlloc();
+    }
+
+    std::vector<std::size_t> offsets(chunks + 1, 0);
+    for(unsigned long c = 0; c < chunks; ++c)
+        offsets[c + 1] = offsets[c] + (selected.empty () ? 0 : parsed[c][0].size ());
+    try
+    {
+        for(auto &column : table.columns)
+            column.resize (offsets[chunks]);
+    }
+    catch (std::bad_alloc& ba)
+    {
+        throw HilbertBadAlloc();
+    }
+    for_each_chunk_parallel (chunks, chunks, [&](unsigned long chunk, unsigned long, unsigned long)
+    {
+        for(std::size_t c = 0; c < selected.size (); ++c)
+        {
+            std::copy(parsed[chunk][c].begin (), parsed[chunk][c].end (), table.columns[c].begin () + offsets[chunk]);
+            std::vector<hfloat>().swap (parsed[chunk][c]);
+        }
+    });
+    return table;
+}
+/*!
+  \overload fromText()
+
+  Returns the \a columns with the given names in the header of the text.
+  \note HilbertBadOperation exception is thrown if a name isn't in the header.
+*/
+CsvLoader::Table CsvLoader::fromText(const char *first, const char *last, const std::vector<std::string> &columns,
+                                     const Options &options)
+{
+    std::vector<std::string> header = readHeader (first, last, options);
+    std::vector<std::size_t> selected;
+    for(const std::string &name : columns)
+    {
+        auto position = std::find(header.begin (), header.end (), name);
+        if(position == header.end ())
+            throw HilbertBadOperation();
+        selected.push_back (position - header.begin ());
+    }
+    Options withHeader = options;
+    withHeader.header = true;
+    return fromText (first, last, selected, withHeader);
+}
+/*!
+  Returns the fields of the first record of the text in [\a first, \a last),
+  without quotes and surrounding blanks.
+*/
+std::vector<std::string> CsvLoader::readHeader(const char *first, const char *last, const Options &options)
+{
+    std::vector<std::string> names;
+    const char *begin;
+    const char *end;
+    bool lastField = false;
+    while(!lastField && first != last)
+    {
+        first = nextField (first, last, options, begin, end, lastField);
+        while(begin != end && isBlank (*begin))
+            ++begin;
+        while(end != begin && isBlank (end[-1]))
+            --end;
+        std::string name;
+        for(const char *p = begin; p != end; ++p)
+        {
+            name.push_back (*p);
+            if(*p == options.quote && p + 1 != end && p[1] == options.quote)
+                ++p;
+        }
+        names.push_back (name);
+    }
+    return names;
+}
+/*!
+  Guesses the delimiter of the text in [\a first, \a last) as the most
+  frequent of comma, tab, semicolon and vertical bar on its first line,
+  outside quotes. Returns a comma if none is found.
+*/
+char CsvLoader::detectDelimiter(const char *first, const char *last)
+{
+    const char candidates[] = {',', '\t', ';', '|'};
+    std::size_t counts[4] = {0, 0, 0, 0};
+    bool quoted = false;
+    for(; first != last && (quoted || *first != '\n'); ++first)
+    {
+        if(*first == '"')
+            quoted = !quoted;
+        else if(!quoted)
+            for(int c = 0; c < 4; ++c)
+                counts[c] += *first == candidates[c];
+    }
+    int best = 0;
+    for(int c = 1; c < 4; ++c)
+        if(counts[c] > counts[best])
+            best = c;
+    return counts[best] ? candidates[best] : ',';
+}
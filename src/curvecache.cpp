@@ -0,0 +1,255 @@
+/*!
+   \headerfile "curvecache.h"
+
+   \title Curve Cache Declaration
+
+   \brief The "curvecache.h" header define CurveCache class
+ */
+#include "curvecache.h"
+#include <algorithm>
+#include <chrono>
+#include "hilbertplot.h"
+
+/*!
+   \class CurveCache
+   \inmodule hilbertlib
+   \ingroup hcurve
+   \brief The \c CurveCache class keeps recently built curves for reuse.
+
+   Curves are identified by their width, height and type, and built as
+   HilbertPlot::constructCurve() does, so they can be given to the
+   HilbertPlot constructors taking a curve. A curve is built only once even
+   if several threads ask for it at the same time.
+
+   curveAsync() starts building the curve in background and returns at once,
+   so the curve can be built while the data of the plot is being loaded.
+
+   Up to capacity() curves are kept; the least recently used one is dropped
+   when a new one is added. Curves still being built are dropped once they
+   are ready, so no caller waits for a build it didn't ask for. Curves
+   already handed out remain valid.
+
+   Dropped curves are kept as CompactCurve, up to compactCapacity() of them,
+   taking about a hundredth of their memory. They are encoded in background,
+   so they appear in the compact tier shortly after being dropped. When one
+   of them is asked again it's decoded instead of built.
+*/
+
+/*!
+  Constructs an empty cache holding up to \a capacity curves and
+  \a compactCapacity compact curves.
+*/
+CurveCache::CurveCache(std::size_t capacity, std::size_t compactCapacity):
+    m_capacity(capacity),
+    m_compactCapacity(compactCapacity)
+{}
+/*!
+  Destroys the cache after the curves being encoded are done.
+*/
+CurveCache::~CurveCache()
+{
+    std::vector<std::future<void>> encodings;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        encodings.swap (m_encodings);
+    }
+    for(auto &encoding : encodings)
+        encoding.wait ();
+}
+/*!
+  Returns the curve of \a width x \a height and \a type, building it if it
+  isn't in the cache.
+*/
+CurveCache::CurvePointer CurveCache::curve(hsize width, hsize height, HilbertCurve::CurveType type)
+{
+    return curveAsync (width, height, type).get ();
+}
+/*!
+  Returns a future for the curve of \a width x \a height and \a type. If the
+  curve isn't in the cache it's built, or decoded from its compact form, on
+  another thread.
+*/
+std::shared_future<CurveCache::CurvePointer> CurveCache::curveAsync(hsize width, hsize height,
+                                                                    HilbertCurve::CurveType type)
+{
+    Key key(width, height, type);
+    // Declared before the lock so evicted curves are released after unlocking
+    CurveList evicted;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto cached = m_index.find (key);
+    if(cached != m_index.end ())
+    {
+        m_curves.splice (m_curves.begin (), m_curves, cached->second);
+        return cached->second->second;
+    }
+
+    std::shared_future<CurvePointer> future;
+    auto compact = m_compactIndex.find (key);
+    if(compact != m_compactIndex.end ())
+    {
+        CompactPointer stored = compact->second->second;
+        m_compactCurves.erase (compact->second);
+        m_compactIndex.erase (compact);
+        future = std::async(std::launch::async, [stored]()
+        {
+            return CurvePointer(new HilbertCurve(stored->toCurve ()));
+        }).share ();
+    }
+    else
+    {
+        future = std::async(std::launch::async, [width, height, type]()
+        {
+            hsize w = width;
+            hsize h = height;
+            return CurvePointer(new HilbertCurve(HilbertPlot::constructCurve (w * h, w, h, type)));
+        }).share ();
+    }
+    if(m_capacity > 0)
+    {
+        m_curves.push_front (std::make_pair(key, future));
+        m_index[key] = m_curves.begin ();
+        evict (evicted);
+    }
+    return future;
+}
+/*!
+  Returns the number of cached curves.
+*/
+std::size_t CurveCache::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_curves.size ();
+}
+/*!
+  Returns the maximum number of cached curves.
+*/
+std::size_t CurveCache::capacity() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_capacity;
+}
+/*!
+  Sets the maximum number of cached curves to \a capacity, dropping the least
+  recently used ones if needed. A capacity of zero disables caching.
+*/
+void CurveCache::setCapacity(std::size_t capacity)
+{
+    CurveList evicted;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_capacity = capacity;
+    evict (evicted);
+}
+/*!
+  Returns the number of cached compact curves.
+*/
+std::size_t CurveCache::compactSize() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_compactCurves.size ();
+}
+/*!
+  Returns the maximum number of dropped curves kept as CompactCurve.
+*/
+std::size_t CurveCache::compactCapacity() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_compactCapacity;
+}
+/*!
+  Sets the maximum number of dropped curves kept as CompactCurve to
+  \a capacity. A capacity of zero disables them.
+*/
+void CurveCache::setCompactCapacity(std::size_t capacity)
+{
+    CurveList evicted;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_compactCapacity = capacity;
+    evict (evicted);
+}
+/*!
+  Drops all the cached curves.
+*/
+void CurveCache::clear()
+{
+    CurveList evicted;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    evicted.swap (m_curves);
+    m_index.clear ();
+    m_compactCurves.clear ();
+    m_compactIndex.clear ();
+}
+/*!
+  Returns the global cache.
+*/
+CurveCache &CurveCache::instance()
+{
+    static CurveCache cache;
+    return cache;
+}
+
+// Moves the least recently used curves over capacity to evicted, for the
+// caller to release after unlocking. Curves still being built stay until
+// they are ready: a future may be the last reference to its task, and
+// destroying it would wait for the build. The cache can then hold more than
+// capacity() curves for a while. The evicted curves are encoded as
+// CompactCurve in background, so the lock isn't held while encoding.
+void CurveCache::evict(CurveList &evicted)
+{
+    auto entry = m_curves.end ();
+    while(m_curves.size () > m_capacity && entry != m_curves.begin ())
+    {
+        --entry;
+        if(entry->second.wait_for (std::chrono::seconds(0)) != std::future_status::ready)
+            continue;
+        m_index.erase (entry->first);
+        evicted.splice (evicted.begin (), m_curves, entry++);
+    }
+    trimCompact ();
+    if(evicted.empty () || m_compactCapacity == 0)
+        return;
+
+    // Finished encodings are released, they don't wait
+    m_encodings.erase (std::remove_if(m_encodings.begin (), m_encodings.end (), [](const std::future<void> &encoding)
+    {
+        return encoding.wait_for (std::chrono::seconds(0)) == std::future_status::ready;
+    }), m_encodings.end ());
+    std::shared_ptr<CurveList> curves = std::make_shared<CurveList>();
+    curves->swap (evicted);
+    m_encodings.push_back (std::async(std::launch::async, [this, curves]()
+    {
+        keepCompact (*curves);
+    }));
+}
+// Encodes the evicted curves as CompactCurve without holding the lock, and
+// adds them unless they were asked again meanwhile.
+void CurveCache::keepCompact(const CurveList &curves)
+{
+    for(const auto &entry : curves)
+    {
+        CompactPointer compact;
+        try
+        {
+            compact = std::make_shared<const CompactCurve>(*entry.second.get ());
+        }
+        catch (...)
+        {
+            // A curve that failed to build is not kept.
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_compactCapacity == 0 || m_index.count (entry.first) || m_compactIndex.count (entry.first))
+            continue;
+        m_compactCurves.push_front (std::make_pair(entry.first, compact));
+        m_compactIndex[entry.first] = m_compactCurves.begin ();
+        trimCompact ();
+    }
+}
+// Drops the oldest compact curves over compactCapacity().
+void CurveCache::trimCompact()
+{
+    while(m_compactCurves.size () > m_compactCapacity)
+    {
+        m_compactIndex.erase (m_compactCurves.back ().first);
+        m_compactCurves.pop_back ();
+    }
+}
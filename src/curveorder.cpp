@@ -0,0 +1,161 @@
+/*!
+   \headerfile "curveorder.h"
+
+   \title Curve Order Declaration
+
+   \brief The "curveorder.h" header define CurveOrder class
+ */
+#include "curveorder.h"
+#include "hilbertplot.h"
+#include "parallel_algorithm.h"
+
+namespace
+{
+// Calls f(begin, end) for consecutive blocks of curve points, spread among
+// threads. Blocks of a Hilbert curve cover compact regions of the plane, so
+// each one touches a few image rows that stay in cache.
+template <typename Func>
+void forEachBlock(const HilbertCurve &curve, Func f)
+{
+    unsigned long lenght = curve.lenght ();
+    for_each_chunk_parallel (lenght, parallel_chunk_count (lenght, CURVE_ORDER_BLOCK_SIZE),
+                             [&](unsigned long, unsigned long begin, unsigned long end)
+    {
+        for(unsigned long block = begin; block < end; block += CURVE_ORDER_BLOCK_SIZE)
+            f(block, std::min(end, block + CURVE_ORDER_BLOCK_SIZE));
+    });
+}
+
+void checkImage(const HilbertCurve &curve, const HImage &image)
+{
+    if(image.size () != curve.width ())
+        throw HilbertBadSize();
+    for(const std::vector<hfloat> &column : image)
+    {
+        if(column.size () != curve.height ())
+            throw HilbertBadSize();
+    }
+}
+}
+
+/*!
+   \class CurveOrder
+   \inmodule hilbertlib
+   \ingroup hcurve
+   \brief The \c CurveOrder class reorders 2D images into the order of a
+   HilbertCurve and back.
+
+   It's the inverse of a HilbertPlot: gather() reads the pixels of an image
+   following the curve, giving the sequence whose plot is the image, and
+   scatter() writes a sequence back in place. They work with any CurveType,
+   directly between the given buffers without intermediate allocations, and
+   split the curve in blocks handled in parallel.
+
+   Images are either row-major buffers, where pixel (x, y) is at
+   \c{y * stride + x}, or HImage matrices indexed as image[x][y].
+*/
+
+/*!
+  Writes to \a output the pixels of the row-major \a image with rows of
+  \a stride values, in the order of \a curve. \a output must hold
+  curve.lenght() values and the image curve.height() rows.
+
+  Throws HilbertBadSize if \a stride is smaller than the curve width.
+*/
+void CurveOrder::gather(const HilbertCurve &curve, const hfloat *image, std::size_t stride, hfloat *output)
+{
+    if(stride < curve.width ())
+        throw HilbertBadSize();
+    forEachBlock (curve, [&](std::size_t begin, std::size_t end)
+    {
+        for(std::size_t i = begin; i < end; ++i)
+        {
+            const HPoint &point = curve[i];
+            output[i] = image[point.Y () * stride + point.X ()];
+        }
+    });
+}
+/*!
+  \overload gather()
+
+  Reads the pixels from \a image, indexed as image[x][y].
+
+  Throws HilbertBadSize if the image isn't curve.width() x curve.height().
+*/
+void CurveOrder::gather(const HilbertCurve &curve, const HImage &image, hfloat *output)
+{
+    checkImage (curve, image);
+    forEachBlock (curve, [&](std::size_t begin, std::size_t end)
+    {
+        for(std::size_t i = begin; i < end; ++i)
+        {
+            const HPoint &point = curve[i];
+            output[i] = image[point.X ()][point.Y ()];
+        }
+    });
+}
+/*!
+  Writes the curve.lenght() \a values, taken in the order of \a curve, to the
+  row-major \a image with rows of \a stride values. Pixels outside the curve
+  are left unchanged.
+
+  Throws HilbertBadSize if \a stride is smaller than the curve width.
+*/
+void CurveOrder::scatter(const HilbertCurve &curve, const hfloat *values, hfloat *image, std::size_t stride)
+{
+    if(stride < curve.width ())
+        throw HilbertBadSize();
+    forEachBlock (curve, [&](std::size_t begin, std::size_t end)
+    {
+        for(std::size_t i = begin; i < end; ++i)
+        {
+            const HPoint &point = curve[i];
+            image[point.Y () * stride + point.X ()] = values[i];
+        }
+    });
+}
+/*!
+  \overload scatter()
+
+  Writes the pixels to \a image, indexed as image[x][y].
+
+  Throws HilbertBadSize if the image isn't curve.width() x curve.height().
+*/
+void CurveOrder::scatter(const HilbertCurve &curve, const hfloat *values, HImage &image)
+{
+    checkImage (curve, image);
+    forEachBlock (curve, [&](std::size_t begin, std::size_t end)
+    {
+        for(std::size_t i = begin; i < end; ++i)
+        {
+            const HPoint &point = curve[i];
+            image[point.X ()][point.Y ()] = values[i];
+        }
+    });
+}
+/*!
+  Returns the pixels of the row-major \a width x \a height \a image in the
+  order of the curve of \a type that a HilbertPlot of that size uses, so the
+  plot of the result is the image again.
+*/
+DataSequence CurveOrder::fromImage(const hfloat *image, hsize width, hsize height, HilbertCurve::CurveType type)
+{
+    HilbertCurve curve = HilbertPlot::constructCurve (hsize(width) * height, width, height, type);
+    DataSequence output(curve.lenght (), 0.0);
+    gather (curve, image, width, output.data ());
+    return output;
+}
+/*!
+  \overload fromImage()
+
+  Returns the pixels of \a image, indexed as image[x][y].
+*/
+DataSequence CurveOrder::fromImage(const HImage &image, HilbertCurve::CurveType type)
+{
+    hsize width = image.size ();
+    hsize height = image.empty () ? 0 : image.front ().size ();
+    HilbertCurve curve = HilbertPlot::constructCurve (hsize(width) * height, width, height, type);
+    DataSequence output(curve.lenght (), 0.0);
+    gather (curve, image, output.data ());
+    return output;
+}
@@ -8,17 +8,17 @@
   */
 #include "datasequence.h"
 
-#include <fftw3.h>
 #include <cmath>
-#include <cassert>
 #include <algorithm>
 #include <exception>
 #include <numeric>
-#include <sstream>
 #include <fstream>
 #include <iostream>
 
-hfloat zlog(hfloat val);
+#include "dataview.h"
+#include "mappedfile.h"
+#include "numberparser.h"
+#include "textexporter.h"
 
 /*!
   \class DataSequence
@@ -62,7 +62,7 @@ DataSequence::DataSequence(const DataSequence &data):
   Move constructor. Transfers \a data
 */
 DataSequence::DataSequence(DataSequence &&data):
-    std::vector<hfloat>(data)
+    std::vector<hfloat>(std::move(data))
 {}
 DataSequence::DataSequence(std::initializer_list<hfloat> data):
     std::vector<hfloat>(data)
@@ -709,73 +709,11 @@ DataSequence DataSequence::operator||(const DataSequence &d)  const
   Returns the fourier transform of the given data.
   If \a logflag is set to \c true the values will be normalized
   using logarithm.
+  \sa DataView::fourierTransform()
 */
 DataSequence DataSequence::fourierTransform(bool logflag) const
 {
-    if(size () == 0) throw HilbertBadOperation();
-
-    double *datainput=NULL;
-    fftw_complex *dataoutput=NULL;
-    fftw_plan p;
-    int data_size = size ();
-    int i=0;
-    int data_size2=data_size/2;
-    DataSequence output;
-
-    try
-    {
-        datainput = (double*) fftw_malloc(sizeof(double) * data_size);
-        dataoutput = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * (data_size2+2));
-        if(datainput == NULL || dataoutput == NULL)
-          throw std::bad_alloc(); // memory exhausted
-
-        assert(datainput != NULL || dataoutput != NULL);
-
-        p = fftw_plan_dft_r2c_1d(data_size, datainput, dataoutput, FFTW_ESTIMATE); // the transform
-
-        for(auto val : (*this))
-        { // filling the data
-            assert(i < data_size);
-            datainput[i++]=val;
-        }
-
-        fftw_execute(p); // the transform
-
-        output.assign (data_size+1, 0);
-
-    }catch (std::bad_alloc& ba)
-    {
-        throw HilbertBadAlloc();
-    }
-
-    // arranging transform data into redundant centered output
-    for(i=1; i <= data_size2; ++i)
-    {
-        assert(data_size2+i <= data_size && data_size2+i >= 0);
-        assert(data_size2-i <= data_size && data_size2-i >= 0);
-
-        output[data_size2+i]=output[data_size2-i]=dataoutput[i][0]*dataoutput[i][0]+dataoutput[i][1]*dataoutput[i][1];
-        if(logflag)
-        {
-               if(output[data_size2-i]>0)
-                   output[data_size2-i]=output[data_size2+i]=log(sqrt(output[data_size2-i]));
-        }
-    }
-    output[data_size2]=dataoutput[0][0]*dataoutput[0][0]+dataoutput[0][1]*dataoutput[0][1];
-
-    if(logflag)
-    {
-           if(output[data_size2]>0)
-               output[data_size2]=log(sqrt(output[data_size2]));
-    }
-
-    fftw_destroy_plan(p);
-    fftw_free(datainput);
-    fftw_free(dataoutput);
-
-    output.pop_back();
-
-    return output;
+    return DataView(*this).fourierTransform (logflag);
 }
 /*!
   Returns a new data wich elements are the Hamming distance between
@@ -926,18 +864,18 @@ DataSequence &DataSequence::granularity(uint n)
     return *this;
 }
 /*!
-  \brief Returns the minimum value in the data.
+  \brief Returns the maximum value in the data.
 */
 hfloat DataSequence::max() const
 {
-    return *std::max_element(begin (), end ());
+    return DataView(*this).max ();
 }
 /*!
-  \brief Returns the maximum value in the data.
+  \brief Returns the minimum value in the data.
 */
 hfloat DataSequence::min() const
 {
-    return *std::min_element(begin (), end ());
+    return DataView(*this).min ();
 }
 /*!
  * \fn DataSequence::mean() const
@@ -945,9 +883,7 @@ hfloat DataSequence::min() const
  */
 hfloat DataSequence::mean() const
 {
-    if(size () == 0) return 0;
-    hfloat sum = std::accumulate(begin (), end (), 0);
-    return sum/hfloat(size ());
+    return DataView(*this).mean ();
 }
 /*!
  * \brief DataSequence::stdDeviation
@@ -955,14 +891,7 @@ hfloat DataSequence::mean() const
  */
 hfloat DataSequence::stdDeviation() const
 {
-    if(size () < 2) return 0;
-    hfloat meanValue = mean ();
-    hfloat sum = 0;
-    for(const hfloat &val : (*this))
-    {
-        sum += (val - meanValue)*(val - meanValue);
-    }
-    return std::sqrt(1.0/hfloat(size ()-1)*sum);
+    return DataView(*this).stdDeviation ();
 }
 /*!
  * \fn DataSequence::Entropy() const
@@ -971,68 +900,80 @@ hfloat DataSequence::stdDeviation() const
  */
 hfloat DataSequence::Entropy() const
 {
-    std::vector<unsigned long> freq;
-    hfloat max=0;
-    hfloat min=0;
-    hfloat minmax=0;
-    int index=0;
-
-    if(size() == 0)
-      throw HilbertBadSize();
-
-    try
-    {
-        freq.assign (ENTROPY_LEVELS+3, 0);
-    } catch  (std::bad_alloc& ba)
-    {
-        throw HilbertBadAlloc();
-    }
-
-    max = this->max ();
-    min = this->min ();
+    return DataView(*this).Entropy ();
+}
+/*!
+  \brief Maps the data into \a levels symbols.
+  \sa DataView::symbolize()
+*/
+std::vector<hint> DataSequence::symbolize(hsize levels) const
+{
+    return DataView(*this).symbolize (levels);
+}
+/*!
+  \brief Compute the block entropies of the data.
 
-    minmax = ENTROPY_LEVELS/(max-min);
+  Returns H(L) for block lenghts up to \a maxLength of the data symbolized
+  in \a levels symbols.
+  \sa DataView::blockEntropy(), entropyRate(), excessEntropy()
+*/
+DataSequence DataSequence::blockEntropy(hsize maxLength, hsize levels) const
+{
+    return DataView(*this).blockEntropy (maxLength, levels);
+}
+/*!
+  \brief Estimate the entropy rate from a \a blockEntropy curve.
 
-    for(auto instance : (*this))
-    {
-        index=static_cast<unsigned int>(floor((instance-min)*minmax));
-        assert(index < ENTROPY_LEVELS+1);
-        freq[index]++;
-    }
+  The entropy rate is estimated as the last block entropy gain
+  \c{H(L) - H(L-1)}, where \a blockEntropy is the result of blockEntropy().
+*/
+hfloat DataSequence::entropyRate(const DataSequence &blockEntropy)
+{
+    if(blockEntropy.size () < 2)
+        throw HilbertBadSize();
+    hsize L = blockEntropy.size () - 1;
+    return blockEntropy[L] - blockEntropy[L - 1];
+}
+/*!
+  \brief Estimate the excess entropy from a \a blockEntropy curve.
 
-    hfloat val=0;
-    int nbins = 0;
-    for(auto instance : freq)
-    {
-        nbins += instance != 0;
-        val=val+instance*zlog(instance);
-    }
-    nbins += nbins == 1;
-    return (-val/size()+zlog(size()))/std::log(nbins);
+  The excess entropy is the sum over \c L of the block entropy gains
+  minus the entropy rate, that is \c{H(L) - L * h} for the largest \c L.
+  \sa entropyRate()
+*/
+hfloat DataSequence::excessEntropy(const DataSequence &blockEntropy)
+{
+    hfloat rate = entropyRate (blockEntropy);
+    hsize L = blockEntropy.size () - 1;
+    return blockEntropy[L] - L * rate;
 }
 
 
 /*!
   \brief Load a data in plain text format from \a input stream.
+
+  Values are extracted with NumberParser, so any non numerical character
+  is treated as a separator.
+  \sa onlyNumbers()
 */
 DataSequence DataSequence::fromPlainText(std::istream &input)
 {
-    std::vector<hfloat> data;
     // Get the lenght of the stream
     input.seekg(0, input.end);
-    int lenght = input.tellg();
+    std::streamoff lenght = input.tellg();
     input.seekg(0, input.beg);
     // Buffer to store the file
-    std::string buffer(lenght, '\0');
-    input.read(&buffer[0], lenght); // Reading the whole file into buffer
-    onlyNumbers (buffer);
-    std::stringstream stream(buffer);
-    hfloat val;
-    while (stream >> val)
+    std::string buffer;
+    try
+    {
+        buffer.assign (lenght > 0 ? lenght : 0, '\0');
+    }
+    catch (std::bad_alloc& ba)
     {
-        data.push_back (val);
+        throw HilbertBadAlloc();
     }
-    return DataSequence(data);
+    input.read(&buffer[0], lenght); // Reading the whole file into buffer
+    return fromPlainText (buffer.data (), buffer.data () + input.gcount ());
 }
 /*!
   \overload fromPlainText()
@@ -1040,8 +981,33 @@ DataSequence DataSequence::fromPlainText(std::istream &input)
 */
 DataSequence DataSequence::fromPlainText(std::string &input)
 {
-    std::stringstream ss(input);
-    return fromPlainText (ss);
+    return fromPlainText (input.data (), input.data () + input.size ());
+}
+/*!
+  \overload fromPlainText()
+  \brief Load a data in plain text format from the characters in [\a first, \a last).
+
+  Big inputs are split in chunks parsed concurrently.
+  \sa NumberParser::parseParallel()
+*/
+DataSequence DataSequence::fromPlainText(const char *first, const char *last)
+{
+    DataSequence data;
+    NumberParser::parseParallel (first, last, data);
+    return data;
+}
+/*!
+  \brief Load a data in plain text format from the file at \a path.
+
+  The file is memory mapped and parsed in parallel, without reading it
+  into an intermediate buffer.
+  \note HilbertIOError exception is thrown if the file can't be opened.
+*/
+DataSequence DataSequence::fromPlainTextFile(const std::string &path)
+{
+    MappedFile file(path);
+    file.advise (0, file.size (), MappedFile::Sequential);
+    return fromPlainText (file.data (), file.data () + file.size ());
 }
 /*!
   \brief Get rid of non numerical characters.
@@ -1069,7 +1035,7 @@ std::string DataSequence::onlyNumbers(std::string &input_string)
 */
 bool DataSequence::isNumeric(char ch)
 {
-    return std::isdigit (ch)|| ch == '.' || ch == '-' || ch == '+';
+    return NumberParser::isNumeric (ch);
 }
 /*!
   \overload operator||()
@@ -1151,21 +1117,10 @@ DataSequence operator/(const hfloat &val, const DataSequence &d)
     return newData;
 }
 /*!
-  Takes logarithm of \a val giving zero if \a val is non positive.
-*/
-inline hfloat zlog(hfloat val)
-{
-    hfloat r=0;
-    if (val > 0)
-        r=log(val);
-    return r;
-}
-/*!
-  \brief Print the data.
+  \brief Print the data, a value per line, with the shortest digits that read back exactly.
 */
 std::ostream &operator<<(std::ostream &out, DataSequence &data)
 {
-    for(auto val:data)
-        out << val;
+    TextExporter::write (DataView(data), out);
     return  out;
 }
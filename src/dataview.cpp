@@ -0,0 +1,430 @@
+/*!
+   \headerfile "dataview.h"
+
+   \title Data View Declaration
+
+   \brief The "dataview.h" header define DataView class
+ */
+#include "dataview.h"
+#include "datasequence.h"
+
+#include <fftw3.h>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+#include "parallel_algorithm.h"
+
+namespace
+{
+// Logarithm of val, zero if val is non positive.
+hfloat zlog(hfloat val)
+{
+    hfloat r=0;
+    if (val > 0)
+        r=log(val);
+    return r;
+}
+// Block counts bigger than this are counted with a hash table instead of a
+// dense histogram.
+const unsigned long long DENSE_BLOCK_LIMIT = 1 << 20;
+// Multiplier used for hashing blocks that don't fit exactly in 64 bits.
+const unsigned long long BLOCK_HASH_BASE = 0x9E3779B97F4A7C15ull;
+
+// Shannon entropy, in bits, of a block histogram with total blocks.
+hfloat histogramEntropy(const std::vector<unsigned long> &counts, hfloat total)
+{
+    hfloat val = 0;
+    for(auto count : counts)
+        val += count * zlog(count);
+    return (zlog(total) - val/total) / LOG2;
+}
+hfloat histogramEntropy(const std::unordered_map<unsigned long long, unsigned long> &counts, hfloat total)
+{
+    hfloat val = 0;
+    for(auto &count : counts)
+        val += count.second * zlog(count.second);
+    return (zlog(total) - val/total) / LOG2;
+}
+}
+
+/*!
+   \class DataView
+   \inmodule hilbertlib
+   \ingroup hdata
+   \brief The \c DataView class is a read-only view over a contiguous
+   sequence of \c hfloat values.
+
+   A DataView doesn't copy the values it refers to. They may belong to a
+   DataSequence, a memory mapped file or a buffer from another library. The
+   view can optionally share the ownership of the memory through owner(),
+   which keeps it alive as long as any view of it exists; otherwise the
+   caller must guarantee the memory outlives the view.
+
+   Views of a DataSequence or a \c std::vector<hfloat> are built explicitly,
+   as in \c{DataView(sequence)}, so a view never binds to a temporary unseen.
+   The statistics and the Fourier transform of DataSequence are computed on
+   views, so they are available for external memory without copying it.
+*/
+
+/*!
+  Constructs an empty view.
+*/
+DataView::DataView():
+    m_data(nullptr), m_size(0)
+{}
+/*!
+  Constructs a view of \a size values starting at \a data. If \a owner is given
+  it's kept alive while the view, or any view derived from it, exists.
+*/
+DataView::DataView(const hfloat *data, size_type size, std::shared_ptr<const void> owner):
+    m_data(data), m_size(size), m_owner(std::move(owner))
+{}
+/*!
+  Constructs a view of the values of \a data. The view doesn't own the values,
+  so it's explicit to keep a view from binding silently to a temporary vector.
+*/
+DataView::DataView(const std::vector<hfloat> &data):
+    m_data(data.data ()), m_size(data.size ())
+{}
+/*!
+  Returns the value at \a index.
+  \note HilbertIndexOutOfRange() exception is thrown if the given index isn't valid.
+*/
+const hfloat &DataView::at(size_type index) const
+{
+    if(index >= m_size)
+        throw HilbertIndexOutOfRange();
+    return m_data[index];
+}
+/*!
+  Returns a view of \a count values starting at \a offset, sharing the owner of this view.
+  \note HilbertIndexOutOfRange() exception is thrown if the range isn't inside the view.
+*/
+DataView DataView::subview(size_type offset, size_type count) const
+{
+    if(offset > m_size || count > m_size - offset)
+        throw HilbertIndexOutOfRange();
+    return DataView(m_data + offset, count, m_owner);
+}
+/*!
+  Returns a copy of the values as a DataSequence.
+*/
+DataSequence DataView::toSequence() const
+{
+    DataSequence sequence;
+    try
+    {
+        sequence.assign (begin (), end ());
+    }
+    catch (std::bad_alloc& ba)
+    {
+        throw HilbertBadAlloc();
+    }
+    return sequence;
+}
+/*!
+  Returns the object keeping the viewed memory alive, if any.
+*/
+const std::shared_ptr<const void> &DataView::owner() const
+{
+    return m_owner;
+}
+/*!
+  Returns a view owning \a data. The values are moved, not copied.
+*/
+DataView DataView::fromSequence(DataSequence &&data)
+{
+    std::shared_ptr<const DataSequence> owner = std::make_shared<const DataSequence>(std::move(data));
+    return DataView(owner->data (), owner->size (), owner);
+}
+/*!
+  Returns the fourier transform of the given data.
+  If \a logflag is set to \c true the values will be normalized
+  using logarithm.
+*/
+DataSequence DataView::fourierTransform(bool logflag) const
+{
+    if(size () == 0) throw HilbertBadOperation();
+
+    double *datainput=NULL;
+    fftw_complex *dataoutput=NULL;
+    fftw_plan p;
+    int data_size = size ();
+    int i=0;
+    int data_size2=data_size/2;
+    DataSequence output;
+
+    try
+    {
+        datainput = (double*) fftw_malloc(sizeof(double) * data_size);
+        dataoutput = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * (data_size2+2));
+        if(datainput == NULL || dataoutput == NULL)
+          throw std::bad_alloc(); // memory exhausted
+
+        assert(datainput != NULL || dataoutput != NULL);
+
+        p = fftw_plan_dft_r2c_1d(data_size, datainput, dataoutput, FFTW_ESTIMATE); // the transform
+
+        for(auto val : (*this))
+        { // filling the data
+            assert(i < data_size);
+            datainput[i++]=val;
+        }
+
+        fftw_execute(p); // the transform
+
+        output.assign (data_size+1, 0);
+
+    }catch (std::bad_alloc& ba)
+    {
+        throw HilbertBadAlloc();
+    }
+
+    // arranging transform data into redundant centered output
+    for(i=1; i <= data_size2; ++i)
+    {
+        assert(data_size2+i <= data_size && data_size2+i >= 0);
+        assert(data_size2-i <= data_size && data_size2-i >= 0);
+
+        output[data_size2+i]=output[data_size2-i]=dataoutput[i][0]*dataoutput[i][0]+dataoutput[i][1]*dataoutput[i][1];
+        if(logflag)
+        {
+               if(output[data_size2-i]>0)
+                   output[data_size2-i]=output[data_size2+i]=log(sqrt(output[data_size2-i]));
+        }
+    }
+    output[data_size2]=dataoutput[0][0]*dataoutput[0][0]+dataoutput[0][1]*dataoutput[0][1];
+
+    if(logflag)
+    {
+           if(output[data_size2]>0)
+               output[data_size2]=log(sqrt(output[data_size2]));
+    }
+
+    fftw_destroy_plan(p);
+    fftw_free(datainput);
+    fftw_free(dataoutput);
+
+    output.pop_back();
+
+    return output;
+}
+/*!
+  \brief Returns the maximum value in the data.
+*/
+hfloat DataView::max() const
+{
+    return *std::max_element(begin (), end ());
+}
+/*!
+  \brief Returns the minimum value in the data.
+*/
+hfloat DataView::min() const
+{
+    return *std::min_element(begin (), end ());
+}
+/*!
+ * \fn DataView::mean() const
+ *  Mean value of the data
+ */
+hfloat DataView::mean() const
+{
+    if(size () == 0) return 0;
+    hfloat sum = std::accumulate(begin (), end (), 0.0);
+    return sum/hfloat(size ());
+}
+/*!
+ * \brief Sample standard deviation of the data
+ */
+hfloat DataView::stdDeviation() const
+{
+    if(size () < 2) return 0;
+    hfloat meanValue = mean ();
+    hfloat sum = 0;
+    for(const hfloat &val : (*this))
+    {
+        sum += (val - meanValue)*(val - meanValue);
+    }
+    return std::sqrt(1.0/hfloat(size ()-1)*sum);
+}
+/*!
+ * \fn DataView::Entropy() const
+ * \brief Compute the Shannon entropy of the data
+ *  Shannon information entropy
+ */
+hfloat DataView::Entropy() const
+{
+    std::vector<unsigned long> freq;
+
+    if(size() == 0)
+      throw HilbertBadSize();
+
+    try
+    {
+        freq.assign (ENTROPY_LEVELS, 0);
+    } catch  (std::bad_alloc& ba)
+    {
+        throw HilbertBadAlloc();
+    }
+
+    for(auto symbol : symbolize (ENTROPY_LEVELS))
+    {
+        freq[symbol]++;
+    }
+
+    hfloat val=0;
+    int nbins = 0;
+    for(auto instance : freq)
+    {
+        nbins += instance != 0;
+        val=val+instance*zlog(instance);
+    }
+    nbins += nbins == 1;
+    return (-val/size()+zlog(size()))/std::log(nbins);
+}
+/*!
+  \brief Maps the data into \a levels symbols.
+
+  The range [min(), max()] is split into \a levels bins of equal width
+  and each value is replaced by the index of its bin, so the returned
+  symbols are in range [0, \a levels). This is the symbolization used by
+  Entropy() and blockEntropy().
+*/
+std::vector<hint> DataView::symbolize(hsize levels) const
+{
+    if(levels == 0)
+        throw HilbertBadOperation();
+
+    std::vector<hint> symbols;
+    try
+    {
+        symbols.assign (size (), 0);
+    } catch  (std::bad_alloc& ba)
+    {
+        throw HilbertBadAlloc();
+    }
+    if(size () == 0)
+        return symbols;
+
+    hfloat min = this->min ();
+    hfloat max = this->max ();
+    if(max == min)
+        return symbols;
+
+    hfloat scale = levels/(max-min);
+    hint last = levels - 1;
+    const hfloat *values = data ();
+    for_each_chunk_parallel (size (), parallel_chunk_count (size (), 1 << 16),
+                             [&](unsigned long, unsigned long begin, unsigned long end)
+    {
+        for(unsigned long i = begin; i < end; ++i)
+        {
+            hint symbol = static_cast<hint>((values[i]-min)*scale);
+            symbols[i] = symbol < last ? symbol : last;
+        }
+    });
+    return symbols;
+}
+
+/*!
+  \brief Compute the block entropies of the data.
+
+  Returns a DataSequence of \c{maxLength+1} values where the element \c L is the
+  Shannon entropy H(L), in bits, of the blocks of \c L consecutive symbols. The
+  data is symbolized in \a levels symbols with symbolize(), and H(0) is zero.
+
+  Each block length is counted in one pass over the symbols using a rolling
+  code, split in chunks counted in parallel and merged afterwards.
+
+  \sa entropyRate(), excessEntropy()
+*/
+DataSequence DataView::blockEntropy(hsize maxLength, hsize levels) const
+{
+    if(size () == 0)
+        throw HilbertBadSize();
+    if(maxLength == 0 || maxLength > size () || levels < 2)
+        throw HilbertBadOperation();
+
+    std::vector<hint> symbols = symbolize (levels);
+    DataSequence entropies(maxLength + 1, 0.0);
+    unsigned long long exactSpace = 1;
+    bool exact = true;
+
+    for(hsize L = 1; L <= maxLength; ++L)
+    {
+        // Codes are exact while levels^L fits on 64 bits, hashed otherwise
+        if(exact && exactSpace > std::numeric_limits<unsigned long long>::max() / levels)
+            exact = false;
+        else
+            exactSpace *= levels;
+        unsigned long long base = exact ? levels : BLOCK_HASH_BASE;
+        unsigned long long outWeight = 1;
+        for(hsize i = 1; i < L; ++i)
+            outWeight *= base;
+
+        unsigned long blocks = symbols.size () - L + 1;
+        unsigned long chunks = parallel_chunk_count (blocks, 1 << 16);
+        bool dense = exact && exactSpace <= DENSE_BLOCK_LIMIT;
+        std::vector<std::vector<unsigned long>> denseCounts(dense ? chunks : 0);
+        std::vector<std::unordered_map<unsigned long long, unsigned long>> hashCounts(dense ? 0 : chunks);
+
+        try
+        {
+            for_each_chunk_parallel (blocks, chunks,
+                                     [&](unsigned long chunk, unsigned long begin, unsigned long end)
+            {
+                if(begin == end)
+                    return;
+                unsigned long long code = 0;
+                for(unsigned long i = begin; i < begin + L - 1; ++i)
+                    code = code * base + symbols[i];
+                if(dense)
+                {
+                    std::vector<unsigned long> &counts = denseCounts[chunk];
+                    counts.assign (exactSpace, 0);
+                    for(unsigned long i = begin; i < end; ++i)
+                    {
+                        code = code * base + symbols[i + L - 1];
+                        counts[code]++;
+                        code -= symbols[i] * outWeight;
+                    }
+                }
+                else
+                {
+                    std::unordered_map<unsigned long long, unsigned long> &counts = hashCounts[chunk];
+                    for(unsigned long i = begin; i < end; ++i)
+                    {
+                        code = code * base + symbols[i + L - 1];
+                        counts[code]++;
+                        code -= symbols[i] * outWeight;
+                    }
+                }
+            });
+        }
+        catch (std::bad_alloc& ba)
+        {
+            throw HilbertBadAlloc();
+        }
+
+        // Merging the chunk counts on the first one
+        if(dense)
+        {
+            for(unsigned long c = 1; c < chunks; ++c)
+                for(unsigned long long code = 0; code < exactSpace; ++code)
+                    denseCounts[0][code] += denseCounts[c][code];
+            entropies[L] = histogramEntropy (denseCounts[0], blocks);
+        }
+        else
+        {
+            for(unsigned long c = 1; c < chunks; ++c)
+                for(auto &count : hashCounts[c])
+                    hashCounts[0][count.first] += count.second;
+            entropies[L] = histogramEntropy (hashCounts[0], blocks);
+        }
+    }
+    return entropies;
+}
@@ -7,11 +7,14 @@
 #include <algorithm>
 #include <iostream>
 #include <sstream>
+#include <utility>
 #include <cmath>
 #include <future>
 
 #include "threads_utility.h"
 #include "parallel_algorithm.h"
+#include "hugepages.h"
+#include "svgwriter.h"
 
 
 /*!
@@ -78,7 +81,7 @@ QuasiSquare & QuasiSquare::operator =(const QuasiSquare & qs)
     Perform a even square partition. Partitioned QuasiSquare are returned as
     reference in \a partition_vec.
 */
-std::vector<QuasiSquare> & QuasiSquare::Partition(std::vector<QuasiSquare> & partition_vec)
+QuasiSquare::PartitionList & QuasiSquare::Partition(PartitionList & partition_vec)
 {
     QuasiSquare newQS;
     hsize n1, n2, m1, m2;
@@ -226,17 +229,22 @@ std::vector<QuasiSquare> & QuasiSquare::Partition(std::vector<QuasiSquare> & par
 /*!
   \brief Build the Hilbert Curve recursively.
   Build the Hilbert curve returning the coordinates as reference in \a coordinates_list.
+
+  The partitions of each level are allocated from the current MemoryResource,
+  which the tasks sent to the thread pool keep using.
 */
 std::vector<HPoint> &QuasiSquare::BuildCurve(std::vector<HPoint> & coordinates_list, hsize index)
 {
 
-    std::vector<QuasiSquare> qsv;
+    PartitionList qsv(MemoryResource::current ());
     QuasiSquare qs;
     HPoint p;
 
     if(n > 2 || m > 2)//QuasiSquare isn't a primitive so need to keep Partitioning
     {
+        qsv.reserve (4);
         Partition (qsv);
+        MemoryResource *resource = qsv.get_allocator ().resource ();
         //std::future<void> futures[2];
         for(int i=0; i < 4; ++i)
         {
@@ -246,7 +254,11 @@ std::vector<HPoint> &QuasiSquare::BuildCurve(std::vector<HPoint> & coordinates_l
             if(i < 2)
             {
                 // Wrapping the BuildCurve method in a function object
-                std::function<void()> func = std::bind(&QuasiSquare::BuildCurve, qs, std::ref(coordinates_list), index);
+                std::function<void()> func = [qs, &coordinates_list, index, resource]() mutable
+                {
+                    MemoryResource::Scope scope(resource);
+                    qs.BuildCurve (coordinates_list, index);
+                };
                 // Push the function to the thread pool
                 thread_pool::instance ().push_task(func);
             }
@@ -494,82 +506,29 @@ HilbertCurve::const_iterator HilbertCurve::cend() const
     return m_curve.cend ();
 }
 /*!
-  \fn void HilbertCurve::SaveSVG(const char *filename, const char *colorName, float stroke_width)
+  \fn void HilbertCurve::SaveSVG(const char *filename, const char *colorName, float stroke_width) const
   \brief Export curve as an SVG file
 
   Export the HilbertCurve using SVG format to \a filename, using \a colorName and \a stroke_width
-  to stylish the output curve.
+  to stylish the output curve. See SvgWriter.
   \note \a colorName must be a valid HTML color.
   \note \a stroke_width must be in range [0,1]
 */
-void HilbertCurve::SaveSVG(const char *filename, const char *colorName, float stroke_width)
+void HilbertCurve::SaveSVG(const char *filename, const char *colorName, float stroke_width) const
 {
-    reflectY ();
-    std::ofstream os(filename);
-    std::vector<HPoint> coordinates = m_curve;
-    reflectY ();
-        unsigned int xmax, ymax;
-
-        xmax=std::max_element(coordinates.begin(), coordinates.end(), [](HPoint & p1,HPoint & p2) { return (p1.X() < p2.X()); })->X();
-        ymax=std::max_element(coordinates.begin(), coordinates.end(), [](HPoint & p1,HPoint & p2) { return (p1.Y() < p2.Y()); })->Y();
-
-
-        os << "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\"?>" << std::endl;
-
-        os << "<svg" << std::endl;
-        os << "width=\"" << xmax << "\"" << std::endl;
-        os << "height=\"" << ymax << "\"" << std::endl;
-        os << "id=\"svg2\"" << std::endl;
-        os << "version=\"1.1\">" << std::endl;
-        os << "<g>" << std::endl;
-        os << "<path" << std::endl;
-        os << "style=\"fill:none;stroke:"<< colorName <<";stroke-width:" << stroke_width <<"px;stroke-linecap:butt;stroke-linejoin:miter;stroke-opacity:1\"" << std::endl;
-        os << "d=\"M ";
-        for(auto instance : coordinates)
-            os << instance.X() << "," << instance.Y() << " ";
-        os << "\"/>" << std::endl;
-        os << "</g>" << std::endl;
-        os << "</svg>";
-
-        os.close ();
+    SvgWriter::save (*this, filename, SvgWriter::Options(colorName, stroke_width));
 }
 /*!
   \brief Generate a string with the curve representation as SVG.
   Returns a std::string representing the HilbertCurve using SVG format,
   \a colorName and \a stroke_width
-  are used to stylish the output.
+  are used to stylish the output. See SvgWriter.
   \note \a colorName must be a valid HTML color.
   \note \a stroke_width must be in range [0,1]
 */
-std::string HilbertCurve::curveToSvg(const char *colorName, float stroke_width)
+std::string HilbertCurve::curveToSvg(const char *colorName, float stroke_width) const
 {
-    reflectY ();
-    std::vector<HPoint> coordinates = m_curve;
-    reflectY ();
-    hsize xmax, ymax;
-
-    xmax=std::max_element(coordinates.begin(), coordinates.end(), [](HPoint & p1,HPoint & p2) { return (p1.X() < p2.X()); })->X();
-    ymax=std::max_element(coordinates.begin(), coordinates.end(), [](HPoint & p1,HPoint & p2) { return (p1.Y() < p2.Y()); })->Y();
-
-    std::ostringstream os;
-    os << "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\"?>" << std::endl;
-
-    os << "<svg" << std::endl;
-    os << "width=\"" << xmax << "\"" << std::endl;
-    os << "height=\"" << ymax << "\"" << std::endl;
-    os << "id=\"svg2\"" << std::endl;
-    os << "version=\"1.1\">" << std::endl;
-    os << "<g>" << std::endl;
-    os << "<path" << std::endl;
-    os << "style=\"fill:none;stroke:"<< colorName <<";stroke-width:" << stroke_width <<"px;stroke-linecap:butt;stroke-linejoin:miter;stroke-opacity:1\"" << std::endl;
-    os << "d=\"M ";
-    for(auto instance : coordinates)
-        os << instance.X() << "," << instance.Y() << " ";
-    os << "\"/>" << std::endl;
-    os << "</g>" << std::endl;
-    os << "</svg>";
-
-    return os.str ();
+    return SvgWriter::toString (*this, SvgWriter::Options(colorName, stroke_width));
 }
 
 HilbertCurve HilbertCurve::createCurve(hsize width, hsize height, HilbertCurve::CurveType type, HPoint origen, QuasiSquare::Orientation orientation, bool differenceCurve)
@@ -801,6 +760,9 @@ void HilbertCurve::BuildDifference()
 
 void HilbertCurve::BuildCurveH0()
 {
+    m_curve.clear ();
+    m_curve.reserve (n * m);
+    HugePages::advise (m_curve.data (), m_curve.capacity ()*sizeof(HPoint));
     m_curve.assign (n * m, 0);
     BuildCurve(m_curve, 0);
     // Ok esto funciona bien y es bastante optimo, el riesgo esta en que otro thread
@@ -3374,6 +3336,19 @@ HilbertCurve::HilbertCurve(const HilbertCurve &curve):
     m_mean_difference(curve.meanDifference ())
 {
 }
+/*!
+  \fn HilbertCurve::HilbertCurve(HilbertCurve &&curve)
+  \brief Move Constructor
+  Construct the curve taking the points of the given \a curve, which is left
+  without points.
+*/
+HilbertCurve::HilbertCurve(HilbertCurve &&curve):
+    QuasiSquare(curve.n, curve.m, curve.coord, curve.oABCD),
+    m_type(curve.m_type),
+    m_curve(std::move(curve.m_curve)),
+    m_mean_difference(curve.meanDifference ())
+{
+}
 /*!
   Returns the mean differnece of the curve. BuildDifference() must be called first.
 */
@@ -3432,6 +3407,7 @@ void HilbertCurve::joinCurve(HilbertCurve &cuadrant1, HilbertCurve &cuadrant2, H
 {
     m_curve.clear ();
     m_curve.reserve (width ()*height ());
+    HugePages::advise (m_curve.data (), m_curve.capacity ()*sizeof(HPoint));
     try
     {
         switch (oABCD)
@@ -0,0 +1,373 @@
+/*!
+   \headerfile "hilbertkey.h"
+
+   \title Hilbert Key Declaration
+
+   \brief The "hilbertkey.h" header define HilbertKey class
+ */
+#include "hilbertkey.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+#include "parallel_algorithm.h"
+
+namespace
+{
+const std::size_t KEY_MIN_CHUNK = 1 << 16;
+const uint64_t LOW_WORD = 0xFFFFFFFFull;
+
+inline uint64_t interleave(uint64_t x)
+{
+    x &= LOW_WORD;
+    x = (x | (x << 16)) & 0x0000FFFF0000FFFFull;
+    x = (x | (x << 8)) & 0x00FF00FF00FF00FFull;
+    x = (x | (x << 4)) & 0x0F0F0F0F0F0F0F0Full;
+    x = (x | (x << 2)) & 0x3333333333333333ull;
+    x = (x | (x << 1)) & 0x5555555555555555ull;
+    return x;
+}
+
+// Branch free evaluation of the Hilbert index: the orientation of every level
+// is found with a parallel prefix scan over the bits of x and y instead of a
+// loop over levels, so the loops calling it can be vectorized.
+inline uint64_t hilbertIndex(uint64_t x, uint64_t y, unsigned order)
+{
+    x = (x << (32 - order)) & LOW_WORD;
+    y = (y << (32 - order)) & LOW_WORD;
+
+    uint64_t A, B, C, D;
+    {
+        uint64_t a = x ^ y;
+        uint64_t b = LOW_WORD ^ a;
+        uint64_t c = LOW_WORD ^ (x | y);
+        uint64_t d = x & (y ^ LOW_WORD);
+        A = a | (b >> 1);
+        B = (a >> 1) ^ a;
+        C = ((c >> 1) ^ (b & (d >> 1))) ^ c;
+        D = ((a & (c >> 1)) ^ (d >> 1)) ^ d;
+    }
+    for(unsigned shift = 2; shift <= 8; shift <<= 1)
+    {
+        uint64_t a = A, b = B, c = C, d = D;
+        A = (a & (a >> shift)) ^ (b & (b >> shift));
+        B = (a & (b >> shift)) ^ (b & ((a ^ b) >> shift));
+        C ^= (a & (c >> shift)) ^ (b & (d >> shift));
+        D ^= (b & (c >> shift)) ^ ((a ^ b) & (d >> shift));
+    }
+    {
+        uint64_t a = A, b = B, c = C, d = D;
+        C ^= (a & (c >> 16)) ^ (b & (d >> 16));
+        D ^= (b & (c >> 16)) ^ ((a ^ b) & (d >> 16));
+    }
+    uint64_t a = C ^ (C >> 1);
+    uint64_t b = D ^ (D >> 1);
+    uint64_t i0 = x ^ y;
+    uint64_t i1 = b | (LOW_WORD ^ (i0 | a));
+    return ((interleave (i1) << 1) | interleave (i0)) >> (64 - 2 * order);
+}
+
+void checkOrder(unsigned order)
+{
+    if(order == 0 || order > 32)
+        throw HilbertBadSize();
+}
+
+// Number of keys covered by a curve cell of side 2^level, minus one.
+inline uint64_t keySpan(unsigned level)
+{
+    return level >= 32 ? std::numeric_limits<uint64_t>::max() : (uint64_t(1) << (2 * level)) - 1;
+}
+}
+
+/*!
+   \class HilbertKey
+   \inmodule hilbertlib
+   \ingroup hcurve
+   \brief The \c HilbertKey class computes Hilbert curve keys of 2D points.
+
+   The key of a point is its index along the Hilbert curve covering a
+   2^order x 2^order grid, so points close on the plane tend to have close
+   keys. Keys of up to 32 bits per coordinate fit in 64 bits.
+
+   Real coordinates are first quantized into the grid over given bounds.
+   fromPoints() computes keys of whole arrays in parallel with a branch free
+   closed form that the compiler can vectorize. sort() orders keys, and a
+   payload, with a parallel radix sort, and ranges() decomposes a rectangle of
+   the grid into the key ranges that cover it. HilbertRTree builds a spatial
+   index on top of them.
+
+   All the keys of the class follow the same curve, with the first point at
+   the origin and the last one at (2^order - 1, 0).
+*/
+
+/*!
+  \class HilbertKey::Bounds
+  \inmodule hilbertlib
+  \brief A rectangle of the plane given by its minimum and maximum
+  coordinates, both included.
+*/
+
+/*!
+  Returns the key of the point \a x, \a y on a curve of \a order levels.
+  Only the lower \a order bits of the coordinates are used.
+
+  Throws HilbertBadSize if \a order isn't between 1 and 32.
+*/
+uint64_t HilbertKey::fromPoint(uint32_t x, uint32_t y, unsigned order)
+{
+    checkOrder (order);
+    return hilbertIndex (x, y, order);
+}
+/*!
+  Returns the point with \a key on a curve of \a order levels.
+
+  Throws HilbertBadSize if \a order isn't between 1 and 32.
+*/
+std::pair<uint32_t, uint32_t> HilbertKey::toPoint(uint64_t key, unsigned order)
+{
+    checkOrder (order);
+    uint64_t x = 0, y = 0;
+    for(unsigned level = 0; level < order; ++level)
+    {
+        uint64_t side = uint64_t(1) << level;
+        unsigned quadrant = (key >> (2 * level)) & 3;
+        unsigned rx = quadrant >> 1;
+        unsigned ry = (quadrant ^ rx) & 1;
+        if(ry == 0)
+        {
+            if(rx == 1)
+            {
+                x = side - 1 - x;
+                y = side - 1 - y;
+            }
+            std::swap(x, y);
+        }
+        x += side * rx;
+        y += side * ry;
+    }
+    return std::make_pair(uint32_t(x), uint32_t(y));
+}
+/*!
+  Writes to \a keys the keys of the \a count points with coordinates \a x and
+  \a y on a curve of \a order levels.
+
+  Throws HilbertBadSize if \a order isn't between 1 and 32.
+*/
+void HilbertKey::fromPoints(const uint32_t *x, const uint32_t *y, std::size_t count, uint64_t *keys,
+                            unsigned order)
+{
+    checkOrder (order);
+    for_each_chunk_parallel (count, parallel_chunk_count (count, KEY_MIN_CHUNK),
+                             [&](unsigned long, unsigned long begin, unsigned long end)
+    {
+        for(std::size_t i = begin; i < end; ++i)
+            keys[i] = hilbertIndex (x[i], y[i], order);
+    });
+}
+/*!
+  \overload fromPoints()
+
+  Writes to \a keys the keys of the \a count points with real coordinates \a x
+  and \a y, quantized into the grid over \a bounds, see quantize().
+*/
+void HilbertKey::fromPoints(const hfloat *x, const hfloat *y, std::size_t count, const Bounds &bounds,
+                            uint64_t *keys, unsigned order)
+{
+    checkOrder (order);
+    for_each_chunk_parallel (count, parallel_chunk_count (count, KEY_MIN_CHUNK),
+                             [&](unsigned long, unsigned long begin, unsigned long end)
+    {
+        for(std::size_t i = begin; i < end; ++i)
+        {
+            uint32_t qx = quantize (x[i], bounds.minX, bounds.maxX, order);
+            uint32_t qy = quantize (y[i], bounds.minY, bounds.maxY, order);
+            keys[i] = hilbertIndex (qx, qy, order);
+        }
+    });
+}
+/*!
+  Returns the grid coordinate of \a value in [\a min, \a max] on a curve of
+  \a order levels. Values out of the interval are clamped to it, and NaN
+  gives zero. The quantization is monotonic, so the cells of the points
+  inside a rectangle are inside the cells of the rectangle corners.
+*/
+uint32_t HilbertKey::quantize(hfloat value, hfloat min, hfloat max, unsigned order)
+{
+    if(!(max > min) || !(value > min))
+        return 0;
+    uint64_t cells = uint64_t(1) << order;
+    if(value >= max)
+        return uint32_t(cells - 1);
+    hfloat cell = std::floor((value - min) / (max - min) * hfloat(cells));
+    return uint32_t(std::min<hfloat>(cell, hfloat(cells - 1)));
+}
+/*!
+  Returns the smallest bounds containing the \a count points with
+  coordinates \a x and \a y. NaN coordinates are ignored.
+*/
+HilbertKey::Bounds HilbertKey::boundsOf(const hfloat *x, const hfloat *y, std::size_t count)
+{
+    Bounds bounds{std::numeric_limits<hfloat>::max(), std::numeric_limits<hfloat>::max(),
+                  std::numeric_limits<hfloat>::lowest(), std::numeric_limits<hfloat>::lowest()};
+    for(std::size_t i = 0; i < count; ++i)
+    {
+        bounds.minX = std::min(bounds.minX, x[i]);
+        bounds.maxX = std::max(bounds.maxX, x[i]);
+        bounds.minY = std::min(bounds.minY, y[i]);
+        bounds.maxY = std::max(bounds.maxY, y[i]);
+    }
+    if(count == 0 || bounds.minX > bounds.maxX || bounds.minY > bounds.maxY)
+        return Bounds{0, 0, 0, 0};
+    return bounds;
+}
+/*!
+  Returns the sorted, disjoint key ranges, both ends included, whose cells
+  cover the rectangle from \a minX, \a minY to \a maxX, \a maxY of a curve of
+  \a order levels.
+
+  The rectangle is refined down the curve levels, keeping the cells fully
+  inside it as ranges. When refining further would give more than
+  \a maxRanges ranges, the cells crossing the border are kept whole, so the
+  ranges may also cover some keys outside the rectangle.
+
+  Throws HilbertBadSize if \a order isn't between 1 and 32.
+*/
+std::vector<HilbertKey::Range> HilbertKey::ranges(uint32_t minX, uint32_t minY, uint32_t maxX, uint32_t maxY,
+                                                  unsigned order, std::size_t maxRanges)
+{
+    checkOrder (order);
+    std::vector<Range> output;
+    uint64_t last = (uint64_t(1) << order) - 1;
+    if(minX > maxX || minY > maxY || minX > last || minY > last)
+        return output;
+    uint64_t right = std::min<uint64_t>(maxX, last);
+    uint64_t bottom = std::min<uint64_t>(maxY, last);
+    maxRanges = std::max<std::size_t>(maxRanges, 1);
+
+    // Cells of a level as the first key they cover; their side is 2^level.
+    std::vector<uint64_t> cells(1, 0);
+    for(unsigned level = order; !cells.empty (); --level)
+    {
+        std::vector<uint64_t> crossing;
+        for(uint64_t start : cells)
+        {
+            std::pair<uint32_t, uint32_t> point = toPoint (start, order);
+            uint64_t x0 = uint64_t(point.first) >> level << level;
+            uint64_t y0 = uint64_t(point.second) >> level << level;
+            uint64_t x1 = x0 + (uint64_t(1) << level) - 1;
+            uint64_t y1 = y0 + (uint64_t(1) << level) - 1;
+            if(x1 < minX || x0 > right || y1 < minY || y0 > bottom)
+                continue;
+            if(x0 >= minX && x1 <= right && y0 >= minY && y1 <= bottom)
+                output.push_back (Range(start, start + keySpan (level)));
+            else
+                crossing.push_back (start);
+        }
+        cells.clear ();
+        if(crossing.empty ())
+            break;
+        if(output.size () + 4 * crossing.size () > maxRanges)
+        {
+            for(uint64_t start : crossing)
+                output.push_back (Range(start, start + keySpan (level)));
+            break;
+        }
+        uint64_t quarter = uint64_t(1) << (2 * (level - 1));
+        for(uint64_t start : crossing)
+        {
+            for(uint64_t child = 0; child < 4; ++child)
+                cells.push_back (start + child * quarter);
+        }
+    }
+
+    std::sort(output.begin (), output.end ());
+    std::vector<Range> merged;
+    for(const Range &range : output)
+    {
+        if(!merged.empty () && merged.back ().second + 1 == range.first)
+            merged.back ().second = range.second;
+        else
+            merged.push_back (range);
+    }
+    return merged;
+}
+/*!
+  Sorts the \a count \a keys in increasing order, moving \a values along with
+  them. \a values may be null. The sort is stable, so filling \a values with
+  the positions of the keys gives the sorting permutation.
+
+  It's a parallel radix sort by bytes, that skips the bytes shared by all the
+  keys.
+*/
+void HilbertKey::sort(uint64_t *keys, std::size_t *values, std::size_t count)
+{
+    if(count < 2)
+        return;
+    std::vector<uint64_t> keyBuffer;
+    std::vector<std::size_t> valueBuffer;
+    try
+    {
+        keyBuffer.resize (count);
+        if(values)
+            valueBuffer.resize (count);
+    }
+    catch (std::bad_alloc& ba)
+    {
+        throw HilbertBadAlloc();
+    }
+
+    unsigned long chunks = parallel_chunk_count (count, KEY_MIN_CHUNK);
+    std::vector<std::array<std::size_t, 256>> histograms(chunks);
+    uint64_t *sourceKeys = keys, *targetKeys = keyBuffer.data ();
+    std::size_t *sourceValues = values, *targetValues = values ? valueBuffer.data () : nullptr;
+
+    for(unsigned shift = 0; shift < 64; shift += 8)
+    {
+        for_each_chunk_parallel (count, chunks, [&](unsigned long chunk, unsigned long begin, unsigned long end)
+        {
+            std::array<std::size_t, 256> &histogram = histograms[chunk];
+            histogram.fill (0);
+            for(std::size_t i = begin; i < end; ++i)
+                ++histogram[(sourceKeys[i] >> shift) & 0xFF];
+        });
+
+        bool shared = false;
+        std::size_t offset = 0;
+        for(unsigned digit = 0; digit < 256; ++digit)
+        {
+            std::size_t total = 0;
+            for(unsigned long chunk = 0; chunk < chunks; ++chunk)
+            {
+                std::size_t amount = histograms[chunk][digit];
+                histograms[chunk][digit] = offset + total;
+                total += amount;
+            }
+            shared = shared || total == count;
+            offset += total;
+        }
+        if(shared)
+            continue;
+
+        for_each_chunk_parallel (count, chunks, [&](unsigned long chunk, unsigned long begin, unsigned long end)
+        {
+            std::array<std::size_t, 256> &position = histograms[chunk];
+            for(std::size_t i = begin; i < end; ++i)
+            {
+                std::size_t target = position[(sourceKeys[i] >> shift) & 0xFF]++;
+                targetKeys[target] = sourceKeys[i];
+                if(sourceValues)
+                    targetValues[target] = sourceValues[i];
+            }
+        });
+        std::swap(sourceKeys, targetKeys);
+        std::swap(sourceValues, targetValues);
+    }
+    if(sourceKeys != keys)
+    {
+        std::copy (sourceKeys, sourceKeys + count, keys);
+        if(values)
+            std::copy (sourceValues, sourceValues + count, values);
+    }
+}
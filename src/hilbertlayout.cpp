@@ -0,0 +1,104 @@
+/*!
+   \headerfile "hilbertlayout.h"
+
+   \title Hilbert Layout Declaration
+
+   \brief The "hilbertlayout.h" header define HilbertLayout class
+ */
+#include "hilbertlayout.h"
+
+/*!
+   \class HilbertLayout
+   \inmodule hilbertlib
+   \ingroup hcurve
+   \brief The \c HilbertLayout class maps the cells of a 2D array to memory
+   offsets that follow a HilbertCurve.
+
+   The array is split in square tiles of tile() x tile() cells, stored
+   row-major inside, and the tiles are stored in the order of a HilbertCurve
+   over the tile grid. Neighbour cells are then close in memory in both
+   directions, which improves cache and TLB locality of 2D kernels like
+   stencils, while the tiles keep the inner loops simple. A tile of one cell
+   gives a pure curve order.
+
+   offset() computes the position of a cell from a table with one entry per
+   tile. Partial tiles on the right and bottom borders are padded, so the
+   storage needs size() elements, which may be more than width() x height().
+   fromRowMajor() and toRowMajor() convert whole arrays.
+
+   Kernels get the best locality visiting the tiles in storage order, from
+   0 to tileCount(), using tileOrigin() and tileOffset().
+*/
+
+/*!
+  Constructs an empty layout.
+ */
+HilbertLayout::HilbertLayout():
+    m_width(0), m_height(0), m_tileShift(0), m_tileMask(0), m_tilesX(0)
+{}
+/*!
+  Constructs the layout of a \a width x \a height array with tiles of
+  \a tile x \a tile cells along a curve of \a type.
+
+  Throws HilbertBadSize if \a tile isn't a power of two.
+ */
+HilbertLayout::HilbertLayout(hsize width, hsize height, hsize tile, HilbertCurve::CurveType type):
+    m_width(width), m_height(height), m_tileShift(0), m_tileMask(0), m_tilesX(0)
+{
+    if(tile == 0 || (tile & (tile - 1)) != 0)
+        throw HilbertBadSize();
+    while((hsize(1) << m_tileShift) < tile)
+        ++m_tileShift;
+    m_tileMask = tile - 1;
+    if(width == 0 || height == 0)
+        return;
+
+    m_tilesX = (width + m_tileMask) >> m_tileShift;
+    hsize tilesY = (height + m_tileMask) >> m_tileShift;
+    HilbertCurve curve(m_tilesX, tilesY, type);
+    try
+    {
+        m_tileOffsets.resize (std::size_t(m_tilesX) * tilesY);
+        m_tileOrigins.resize (curve.lenght ());
+    }
+    catch (std::bad_alloc& ba)
+    {
+        throw HilbertBadAlloc();
+    }
+    for(std::size_t i = 0; i < curve.lenght (); ++i)
+    {
+        const HPoint &point = curve[i];
+        m_tileOffsets[std::size_t(point.Y ()) * m_tilesX + point.X ()] = i << (2 * m_tileShift);
+        m_tileOrigins[i] = std::make_pair(point.X () << m_tileShift, point.Y () << m_tileShift);
+    }
+}
+/*!
+  \fn std::size_t HilbertLayout::size() const
+  Returns the number of elements the storage of the layout needs, counting
+  the padding of the border tiles.
+ */
+/*!
+  \fn std::size_t HilbertLayout::offset(hsize x, hsize y) const
+  Returns the position in the storage of the cell at \a x, \a y.
+ */
+/*!
+  \fn std::pair<hsize, hsize> HilbertLayout::tileOrigin(std::size_t tile) const
+  Returns the coordinates of the top left cell of the \a tile stored at that
+  position.
+ */
+/*!
+  \fn std::size_t HilbertLayout::tileOffset(std::size_t tile) const
+  Returns the position in the storage of the first cell of \a tile. The cell
+  (x, y) of the tile follows at \c{y * tile() + x}.
+ */
+/*!
+  \fn template <typename T> void HilbertLayout::fromRowMajor(const T *image, std::size_t stride, T *output) const
+  Copies the row-major \a image, with rows of \a stride elements, to
+  \a output in this layout. \a output must hold size() elements; its padding
+  cells are left unchanged.
+ */
+/*!
+  \fn template <typename T> void HilbertLayout::toRowMajor(const T *values, T *image, std::size_t stride) const
+  Copies \a values in this layout to the row-major \a image, with rows of
+  \a stride elements.
+ */
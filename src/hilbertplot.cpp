@@ -6,11 +6,23 @@
    \brief The "hilbertplot.h" header define HilbertPlot class
  */
 #include "hilbertplot.h"
+#include <algorithm>
 #include <cmath>
 #include <fftw3.h>
 #include <limits>
 #include <iostream>
 
+#include "parallel_algorithm.h"
+
+namespace
+{
+// Curve lenght for size values, saturated to the largest plot.
+hsize clampLenght(std::size_t size)
+{
+    return size > std::numeric_limits<hsize>::max () ? std::numeric_limits<hsize>::max () : hsize(size);
+}
+}
+
 
 /*!
    \class HilbertPlot
@@ -25,6 +37,13 @@
     with a DataSequence. It inheriths public from HilbertCurve, implementing its whole interfaces.
   It also have functionallity for accessing internal DataSequence values.
 
+  The values are held through a DataView, so a plot can be built over external
+  memory, like a memory mapped file, without copying it. When the data is
+  shorter than the curve the remaining cells read as zero without being
+  stored. Copies of a plot share their values until one of them is modified.
+  Data longer than the plot is truncated unless an AggregationMode is given,
+  in which case each cell summarizes a block of values.
+
 */
 
 /*!
@@ -36,41 +55,141 @@
 HilbertPlot::HilbertPlot():
     HilbertPlot(DataSequence(), 0, 0, H0)
 {}
+/*!
+   \enum HilbertPlot::AggregationMode
+
+   How the cells summarize the data when it has more values than the plot.
+   Each cell then covers a contiguous block of the sequence, of nearly the
+   same size for all the cells.
+
+   \value Truncate The values after the last cell are dropped.
+   \value Mean Each cell holds the mean of its block.
+   \value Min Each cell holds the minimum of its block.
+   \value Max Each cell holds the maximum of its block.
+   \value MinMaxEnvelope Each cell holds the minimum or the maximum of its
+           block, whichever is farther from the block mean, so both positive
+           and negative peaks are kept.
+   \value Last Each cell holds the last value of its block.
+*/
+
 /*!
    \brief General Constructor
 
      Constructs the \c HilbertPlot using \a data. If \a width and \a height are given greather
      than zero data will be shrinked or expanding according to given values. If zero is given
      best dimension will be computed. The \c HilbertCurve used is given by \a type.
+     The plot keeps its own copy of \a data.
+
+     When the data doesn't fit in the plot, \a aggregation tells how the cells summarize it.
  */
-HilbertPlot::HilbertPlot(const DataSequence &data, hsize width, hsize height, CurveType type):
-    HilbertCurve (constructCurve (data.size (), width, height, type)),
-    m_data(data)
+HilbertPlot::HilbertPlot(const DataSequence &data, hsize width, hsize height, CurveType type,
+                         AggregationMode aggregation):
+    HilbertPlot(constructCurve (clampLenght (data.size ()), width, height, type), data, aggregation)
+{}
+/*!
+   \overload HilbertPlot()
+
+     Constructs the \c HilbertPlot taking the values of \a data, which are moved instead of copied.
+ */
+HilbertPlot::HilbertPlot(DataSequence &&data, hsize width, hsize height, CurveType type,
+                         AggregationMode aggregation):
+    HilbertPlot(constructCurve (clampLenght (data.size ()), width, height, type), std::move(data), aggregation)
+{}
+/*!
+   \overload HilbertPlot()
+
+     Constructs the \c HilbertPlot over the values viewed by \a data without copying them.
+     The memory must outlive the plot unless the view owns it, see DataView::owner().
+     Cells beyond the end of \a data read as zero, without being stored.
+     Values are only copied if the plot is modified, see replaceValueAt(), or aggregated.
+ */
+HilbertPlot::HilbertPlot(const DataView &data, hsize width, hsize height, CurveType type,
+                         AggregationMode aggregation):
+    HilbertPlot(constructCurve (clampLenght (data.size ()), width, height, type), data, aggregation)
+{}
+/*!
+   \overload HilbertPlot()
+
+     Constructs the \c HilbertPlot of a copy of \a data on an already built \a curve,
+     which must come from constructCurve() or CurveCache. Values beyond the curve
+     lenght are summarized as given by \a aggregation and missing values are zero.
+     This lets the curve be built while the data is being loaded. Only the
+     values that the plot keeps are copied.
+ */
+HilbertPlot::HilbertPlot(const HilbertCurve &curve, const DataSequence &data, AggregationMode aggregation):
+    HilbertCurve (curve),
+    m_aggregation(aggregation)
 {
-    while(m_data.size () < width * height)
-    {
-        m_data.push_back(0);
-    }
-    while(m_data.size () > width * height)
+    try
     {
-        m_data.pop_back();
+        m_storage = std::make_shared<DataSequence>(aggregate (DataView(data), lenght (), aggregation));
     }
-    m_plotToCurve = std::vector<std::vector<hint>>(width, std::vector<hint>(height, 0));
-    for(auto point = HilbertCurve::begin (); point != HilbertCurve::end (); ++point)
+    catch (std::bad_alloc& ba)
     {
-        m_plotToCurve[point->X ()][point->Y()] = point->index;
+        throw HilbertBadAlloc();
     }
-    if(m_data.size () > 0)
+    m_data = DataView(m_storage->data (), m_storage->size ());
+    initialize ();
+}
+/*!
+   \overload HilbertPlot()
+
+     Constructs the \c HilbertPlot on an already built \a curve taking the values
+     of \a data, which are moved instead of copied.
+ */
+HilbertPlot::HilbertPlot(const HilbertCurve &curve, DataSequence &&data, AggregationMode aggregation):
+    HilbertCurve (curve),
+    m_aggregation(aggregation)
+{
+    if(aggregation != Truncate && data.size () > lenght ())
+        m_storage = std::make_shared<DataSequence>(aggregate (DataView(data), lenght (), aggregation));
+    else
     {
-        m_min = m_data.min ();
-        m_max = m_data.max ();
+        m_storage = std::make_shared<DataSequence>(std::move(data));
+        if(m_storage->size () > lenght ())
+            m_storage->resize (lenght ());
     }
-    else
+    m_data = DataView(m_storage->data (), m_storage->size ());
+    initialize ();
+}
+/*!
+   \overload HilbertPlot()
+
+     Constructs the \c HilbertPlot over the values viewed by \a data, without
+     copying them, on an already built \a curve.
+ */
+HilbertPlot::HilbertPlot(const HilbertCurve &curve, const DataView &data, AggregationMode aggregation):
+    HilbertPlot(HilbertCurve(curve), data, aggregation)
+{}
+/*!
+   \overload HilbertPlot()
+
+     Constructs the \c HilbertPlot over the values viewed by \a data taking
+     the points of \a curve instead of copying them.
+ */
+HilbertPlot::HilbertPlot(HilbertCurve &&curve, const DataView &data, AggregationMode aggregation):
+    HilbertCurve (std::move(curve)),
+    m_data(data),
+    m_aggregation(aggregation)
+{
+    if(aggregation != Truncate && m_data.size () > lenght ())
     {
-        m_min = 0;
-        m_max = 0;
+        m_storage = std::make_shared<DataSequence>(aggregate (data, lenght (), aggregation));
+        m_data = DataView(m_storage->data (), m_storage->size ());
     }
+    else if(m_data.size () > lenght ())
+        m_data = m_data.subview (0, lenght ());
+    initialize ();
 }
+/*!
+   \overload HilbertPlot()
+
+     Constructs the \c HilbertPlot over the values viewed by \a data on the
+     curve decoded from \a curve.
+ */
+HilbertPlot::HilbertPlot(const CompactCurve &curve, const DataView &data, AggregationMode aggregation):
+    HilbertPlot(curve.toCurve (), data, aggregation)
+{}
 /*!
   \brief Copy Constructor
    Construct a copy of \a hilbertplot
@@ -78,8 +197,10 @@ HilbertPlot::HilbertPlot(const DataSequence &data, hsize width, hsize height, Cu
 HilbertPlot::HilbertPlot(const HilbertPlot &hilbertplot):
      HilbertCurve(hilbertplot),
      m_data(hilbertplot.m_data),
+    m_storage(hilbertplot.m_storage),
     m_min(hilbertplot.m_min),
     m_max(hilbertplot.m_max),
+    m_aggregation(hilbertplot.m_aggregation),
     m_plotToCurve(hilbertplot.m_plotToCurve)
 {
 }
@@ -118,13 +239,14 @@ std::vector<HPoint>::const_reference HilbertPlot::at(std::vector<HPoint>::size_t
 }
 
 /*!
-  Returns the value stored at given \a index of the curve.
+  Returns the value stored at given \a index of the curve. The padding
+  cells following the plotted data have value zero.
 */
 hfloat HilbertPlot::valueAt(std::vector<hfloat>::size_type index) const
 {
-    if(index >= m_data.size ())
+    if(index >= lenght ())
         throw HilbertIndexOutOfRange();
-    return m_data.at (index);
+    return index < m_data.size () ? m_data[index] : 0;
 }
 /*!
   \overload valueAt()
@@ -136,16 +258,12 @@ hfloat HilbertPlot::valueAt(std::vector<hfloat>::size_type x, std::vector<hfloat
     if(x >= width () || y >= height ())
         throw HilbertIndexOutOfRange();
     hsize index = m_plotToCurve[x][y];
-    if(index >= m_data.size ())
-        throw HilbertIndexOutOfRange();
-    return m_data.at (index);
+    return valueAt (index);
 }
 
 hfloat HilbertPlot::valueNormalizedAt(std::vector<hfloat>::size_type index) const
 {
-    if(index >= m_data.size ())
-        throw HilbertIndexOutOfRange();
-    return (m_data.at (index) - m_min) * (m_min == m_max? 0.0 : 1.0/(m_max - m_min));
+    return (valueAt (index) - m_min) * (m_min == m_max? 0.0 : 1.0/(m_max - m_min));
 }
 
 hfloat HilbertPlot::valueNormalizedAt(std::vector<hfloat>::size_type x, std::vector<hfloat>::size_type y) const
@@ -158,11 +276,11 @@ hfloat HilbertPlot::valueNormalizedAt(std::vector<hfloat>::size_type x, std::vec
 
 void HilbertPlot::replaceValueAt(std::vector<hfloat>::size_type index, hfloat value)
 {
-    if(index >= m_data.size ())
+    if(index >= lenght ())
         throw HilbertIndexOutOfRange();
-    m_data[index] = value;
-    m_max = m_data.max ();
-    m_min = m_data.min ();
+    detach (index < m_data.size () ? m_data.size () : lenght ());
+    (*m_storage)[index] = value;
+    updateRange ();
 }
 
 void HilbertPlot::replaceValueAt(std::vector<hfloat>::size_type x, std::vector<hfloat>::size_type y, hfloat value)
@@ -220,10 +338,22 @@ HImage HilbertPlot::generateImage(hfloat threshold)
 }
 
 /*!
-  Returns a copy of the parent DataSequence
+  Returns a copy of the parent DataSequence, including the padding values.
 */
 DataSequence HilbertPlot::dataCopy() const
 {
+    DataSequence data = m_data.toSequence ();
+    data.resize (lenght (), 0);
+    return data;
+}
+/*!
+  Returns a view of the plotted values, without the padding. The view keeps
+  the values alive even if the plot is destroyed or modified.
+*/
+DataView HilbertPlot::dataView() const
+{
+    if(m_storage)
+        return DataView(m_data.data (), m_data.size (), m_storage);
     return m_data;
 }
 /*!
@@ -232,7 +362,7 @@ DataSequence HilbertPlot::dataCopy() const
 */
 void HilbertPlot::replaceData(const DataSequence &data)
 {
-    if(m_data.size () != data.size ())
+    if(lenght () != data.size ())
     {
         throw HilbertBadSize();
     }
@@ -240,12 +370,14 @@ void HilbertPlot::replaceData(const DataSequence &data)
     hfloat max = data.max ();
     hfloat min = data.min ();
     hfloat minmax = 1.0/(max - min);
-    m_data.clear();
-    m_data.reserve (data.size ());
+    std::shared_ptr<DataSequence> storage = std::make_shared<DataSequence>();
+    storage->reserve (data.size ());
     for(const hfloat &val : data)
     {
-        m_data.push_back ((val - min) * minmax);
+        storage->push_back ((val - min) * minmax);
     }
+    m_storage = storage;
+    m_data = DataView(m_storage->data (), m_storage->size ());
 }
 /*!
   \brief Compute the Fourier Transform of the 2D HilbertPlot.
@@ -253,7 +385,7 @@ void HilbertPlot::replaceData(const DataSequence &data)
 */
 DataSequence HilbertPlot::hpFourierTransform(bool logflag) const
 {
-    if(m_data.size () == 0) throw HilbertBadOperation();
+    if(lenght () == 0) throw HilbertBadOperation();
     double *datainput;
     fftw_complex *dataoutput;
     fftw_plan p;
@@ -365,6 +497,57 @@ DataSequence HilbertPlot::hpFourierTransform(bool logflag) const
 }
 
 
+// Builds the inverse curve map and the value range once m_data is set.
+void HilbertPlot::initialize()
+{
+    m_plotToCurve = std::vector<std::vector<hint>>(width (), std::vector<hint>(height (), 0));
+    for(auto point = HilbertCurve::begin (); point != HilbertCurve::end (); ++point)
+    {
+        m_plotToCurve[point->X ()][point->Y()] = point->index;
+    }
+    updateRange ();
+}
+// Range of the values, counting the zeros of the padding cells.
+void HilbertPlot::updateRange()
+{
+    if(m_data.size () > 0)
+    {
+        m_min = m_data.min ();
+        m_max = m_data.max ();
+        if(m_data.size () < lenght ())
+        {
+            m_min = std::min(m_min, 0.0);
+            m_max = std::max(m_max, 0.0);
+        }
+    }
+    else
+    {
+        m_min = 0;
+        m_max = 0;
+    }
+}
+// Makes the plot the only owner of its values, with at least size values,
+// before modifying them.
+void HilbertPlot::detach(std::size_t size)
+{
+    if(!m_storage || m_storage.use_count () > 1)
+    {
+        std::shared_ptr<DataSequence> storage = std::make_shared<DataSequence>();
+        try
+        {
+            storage->reserve (size);
+            storage->assign (m_data.begin (), m_data.end ());
+        }
+        catch (std::bad_alloc& ba)
+        {
+            throw HilbertBadAlloc();
+        }
+        m_storage = storage;
+    }
+    if(m_storage->size () < size)
+        m_storage->resize (size, 0);
+    m_data = DataView(m_storage->data (), m_storage->size ());
+}
 /*!
   \brief Compute best dimensions to adjust the given \a lenght
 
@@ -408,7 +591,95 @@ std::pair<hsize, hsize> HilbertPlot::bestDimensions(hsize lenght)
     return dim;
 }
 /*!
-  Generate the HilbertCurve for the constructor
+  Returns \a cells values summarizing \a data as given by \a aggregation.
+  Cell \c i covers a contiguous block of the data; blocks differ by one value
+  at most. The cells are computed in parallel, reading the data once.
+
+  If the data fits in the cells, or \a aggregation is \c Truncate, returns
+  the first \a cells values.
+*/
+DataSequence HilbertPlot::aggregate(const DataView &data, std::size_t cells, AggregationMode aggregation)
+{
+    DataSequence output;
+    if(aggregation == Truncate || data.size () <= cells)
+    {
+        DataView head = data.subview (0, std::min(cells, data.size ()));
+        output.assign (head.begin (), head.end ());
+        return output;
+    }
+    try
+    {
+        output.resize (cells);
+    }
+    catch (std::bad_alloc& ba)
+    {
+        throw HilbertBadAlloc();
+    }
+
+    for_each_chunk_parallel (cells, parallel_chunk_count (cells, 256),
+                             [&](unsigned long, unsigned long begin, unsigned long end)
+    {
+        for(std::size_t cell = begin; cell < end; ++cell)
+        {
+            std::pair<std::size_t, std::size_t> block = aggregateBlock (data.size (), cells, cell);
+            BlockAccumulator accumulator;
+            for(const hfloat *value = data.data () + block.first; value != data.data () + block.second; ++value)
+                accumulator.add (*value);
+            output[cell] = accumulator.value (aggregation);
+        }
+    });
+    return output;
+}
+/*!
+  Returns the range [first, second) of the values of a sequence of \a size
+  values that aggregate() summarizes in \a cell out of \a cells. Blocks are
+  contiguous and the first size % cells ones take one value more. If there
+  are no more values than cells, each cell takes a single value and the
+  cells past the end an empty range.
+*/
+std::pair<std::size_t, std::size_t> HilbertPlot::aggregateBlock(std::size_t size, std::size_t cells, std::size_t cell)
+{
+    std::size_t block = size / cells;
+    std::size_t extra = size % cells;
+    std::size_t first = cell * block + std::min(cell, extra);
+    return std::make_pair(first, first + block + (cell < extra ? 1 : 0));
+}
+/*!
+   \class HilbertPlot::BlockAccumulator
+   \brief The \c HilbertPlot::BlockAccumulator struct summarizes a block of
+   values added one by one, so blocks can be aggregated while streaming.
+*/
+
+/*!
+  \fn void HilbertPlot::BlockAccumulator::add(hfloat value)
+  Adds \a value to the block.
+*/
+
+/*!
+  Returns the block summarized as given by \a aggregation; \c Truncate
+  takes its first value. An empty block is zero.
+*/
+hfloat HilbertPlot::BlockAccumulator::value(AggregationMode aggregation) const
+{
+    if(count == 0)
+        return 0.0;
+    hfloat mean = sum / hfloat(count);
+    switch (aggregation)
+    {
+        case Mean: return mean;
+        case Min: return min;
+        case Max: return max;
+        case MinMaxEnvelope: return max - mean >= mean - min ? max : min;
+        case Last: return last;
+        default: return first;
+    }
+}
+/*!
+  \brief Generate the HilbertCurve of a plot.
+
+  Returns the curve used by a plot of \a lenght values, with its difference map.
+  If \a width or \a height are zero they are set to bestDimensions(). The
+  curve type is given by \a type.
 */
 const HilbertCurve HilbertPlot::constructCurve(hsize lenght, hsize &width, hsize &height, CurveType type)
 {
@@ -0,0 +1,442 @@
+/*!
+   \headerfile "hilbertplotbatch.h"
+
+   \title Hilbert Plot Batch Declaration
+
+   \brief The "hilbertplotbatch.h" header define HilbertPlotBatch class
+ */
+#include "hilbertplotbatch.h"
+#include <algorithm>
+#include <cmath>
+#include <fftw3.h>
+#include <limits>
+
+#include "parallel_algorithm.h"
+#include "hugepages.h"
+
+namespace
+{
+// Arranges the r2c spectrum of a width x height plot into a redundant centered
+// output along the curve, as HilbertPlot::hpFourierTransform() does.
+DataSequence arrangeSpectrum(const fftw_complex *spectrum, hsize width, hsize height,
+                             const std::vector<hint> &plotToCurve, bool logflag)
+{
+    hsize w2 = width / 2;
+    std::size_t spectrumSize = std::size_t(height) * (w2 + 1);
+    double max, max2;
+    max = max2 = std::numeric_limits<double>::min();
+    double min = std::numeric_limits<double>::max();
+    for(std::size_t i = 0; i < spectrumSize; ++i)
+    {
+        double v = spectrum[i][0] * spectrum[i][0] + spectrum[i][1] * spectrum[i][1];
+        if(max < v)
+            max = v;
+        if(min > v)
+            min = v;
+        if(max2 < v && v < max)
+            max2 = v;
+    }
+    double maxmin = max2 - min;
+    if(logflag)
+        maxmin = log(maxmin);
+
+    auto indexOf = [&](hsize x, hsize y) { return plotToCurve[std::size_t(x) * height + y]; };
+    auto power = [&](std::size_t i) { return spectrum[i][0] * spectrum[i][0] + spectrum[i][1] * spectrum[i][1]; };
+    DataSequence output(std::size_t(width) * height, 0.0);
+    for(hsize y = 0; y < height; ++y)
+    {
+        for(hsize x = 0; x <= w2; ++x)
+        {
+            double wdf = power (std::size_t(y) * (w2 + 1) + x);
+            if(!logflag)
+            {
+                if(wdf >= max)
+                    wdf = max2;
+                output[indexOf (x, y)] = output[indexOf (width - x - 1, y)] = (wdf - min) / maxmin;
+            }
+            else
+            {
+                if(wdf > max2)
+                    wdf = max2;
+                output[indexOf (x, y)] = output[indexOf (width - x - 1, y)] = log(wdf - min + 1) / maxmin;
+            }
+        }
+        double wdf = power (std::size_t(y) * (w2 + 1));
+        if(!logflag)
+        {
+            if(wdf >= max)
+                wdf = max2;
+            output[indexOf (w2, y)] = (wdf - min) / maxmin;
+        }
+        else
+        {
+            if(wdf > max2)
+                wdf = max2;
+            if(wdf - min > 0)
+                output[indexOf (w2, y)] = log(wdf - min) / maxmin;
+        }
+    }
+    return output;
+}
+
+std::vector<DataView> viewsOf(std::vector<DataSequence> &&channels)
+{
+    std::vector<DataView> views;
+    views.reserve (channels.size ());
+    for(DataSequence &channel : channels)
+        views.push_back (DataView::fromSequence (std::move(channel)));
+    return views;
+}
+
+hsize commonSize(const std::vector<DataView> &channels)
+{
+    if(channels.empty ())
+        return 0;
+    for(const DataView &channel : channels)
+    {
+        if(channel.size () != channels.front ().size ())
+            throw HilbertBadSize();
+    }
+    return channels.front ().size ();
+}
+}
+
+/*!
+   \class HilbertPlotBatch
+   \inmodule hilbertlib
+   \ingroup hcurve
+   \ingroup hdata
+   \brief The \c HilbertPlotBatch class plots several data channels of the
+   same lenght along a single HilbertCurve.
+
+   A HilbertPlot holds its own curve and inverse map, which dominate its
+   memory for short sequences. A batch shares one curve, and a flat inverse
+   map, among all its channels, so plotting N sequences takes the memory of
+   one curve plus the N datasets. Channels are held through DataView, so
+   they can be external memory that isn't copied.
+
+   The values, ranges, images and transforms of each channel are the same
+   as those of a HilbertPlot of that channel, while the per channel work
+   (ranges, normalization, images and 2D Fourier transforms) runs on the
+   channels in parallel.
+*/
+
+/*!
+  Constructs an empty batch.
+ */
+HilbertPlotBatch::HilbertPlotBatch():
+    HilbertPlotBatch(std::vector<DataView>(), 0, 0, HilbertCurve::H0)
+{}
+/*!
+  Constructs a batch over the values viewed by \a channels, without copying
+  them, on a \a width x \a height curve of \a type. If any dimension is zero
+  the best dimensions for the channel lenght are used, see
+  HilbertPlot::bestDimensions().
+
+  Throws HilbertBadSize if the channels don't have the same size.
+ */
+HilbertPlotBatch::HilbertPlotBatch(const std::vector<DataView> &channels, hsize width, hsize height,
+                                   HilbertCurve::CurveType type):
+    HilbertPlotBatch(std::make_shared<const HilbertCurve>(HilbertPlot::constructCurve (commonSize (channels), width,
+                                                                                       height, type)), channels)
+{}
+/*!
+  \overload HilbertPlotBatch()
+
+  Constructs a batch taking the values of \a channels, which are moved instead
+  of copied.
+ */
+HilbertPlotBatch::HilbertPlotBatch(std::vector<DataSequence> &&channels, hsize width, hsize height,
+                                   HilbertCurve::CurveType type):
+    HilbertPlotBatch(viewsOf (std::move(channels)), width, height, type)
+{}
+/*!
+  \overload HilbertPlotBatch()
+
+  Constructs a batch over \a channels on an already built \a curve, for
+  example from CurveCache. Values beyond the curve lenght are dropped and
+  missing values are zero.
+ */
+HilbertPlotBatch::HilbertPlotBatch(const CurvePointer &curve, const std::vector<DataView> &channels):
+    m_curve(curve),
+    m_channels(channels)
+{
+    if(!m_curve)
+        throw HilbertBadOperation();
+    commonSize (m_channels);
+    for(DataView &channel : m_channels)
+    {
+        if(channel.size () > lenght ())
+            channel = channel.subview (0, lenght ());
+    }
+    initialize ();
+}
+/*!
+  Returns the number of channels in the batch.
+ */
+std::size_t HilbertPlotBatch::channelCount() const
+{
+    return m_channels.size ();
+}
+/*!
+  Returns the curve shared by all the channels.
+ */
+const HilbertCurve &HilbertPlotBatch::curve() const
+{
+    return *m_curve;
+}
+
+hsize HilbertPlotBatch::lenght() const
+{
+    return m_curve->lenght ();
+}
+
+hsize HilbertPlotBatch::width() const
+{
+    return m_curve->width ();
+}
+
+hsize HilbertPlotBatch::height() const
+{
+    return m_curve->height ();
+}
+/*!
+  Returns the values of \a channel, without the padding.
+ */
+const DataView &HilbertPlotBatch::channel(std::size_t channel) const
+{
+    checkChannel (channel);
+    return m_channels[channel];
+}
+/*!
+  Returns the value of \a channel at \a index of the curve. The padding cells
+  have value zero.
+ */
+hfloat HilbertPlotBatch::valueAt(std::size_t channel, hsize index) const
+{
+    checkChannel (channel);
+    if(index >= lenght ())
+        throw HilbertIndexOutOfRange();
+    const DataView &values = m_channels[channel];
+    return index < values.size () ? values[index] : 0;
+}
+/*!
+  \overload valueAt()
+  Returns the value of \a channel at coordinates \a x and \a y.
+ */
+hfloat HilbertPlotBatch::valueAt(std::size_t channel, hsize x, hsize y) const
+{
+    return valueAt (channel, indexOf (x, y));
+}
+
+hfloat HilbertPlotBatch::valueNormalizedAt(std::size_t channel, hsize index) const
+{
+    hfloat value = valueAt (channel, index);
+    hfloat min = m_min[channel], max = m_max[channel];
+    return (value - min) * (min == max ? 0.0 : 1.0 / (max - min));
+}
+
+hfloat HilbertPlotBatch::valueNormalizedAt(std::size_t channel, hsize x, hsize y) const
+{
+    return valueNormalizedAt (channel, indexOf (x, y));
+}
+/*!
+  \brief Return the index of the curve corresponding to the \a x , \a y coordinate.
+ */
+hint HilbertPlotBatch::indexOf(hint x, hint y) const
+{
+    if(x >= width () || y >= height ())
+        throw HilbertIndexOutOfRange();
+    return m_plotToCurve[std::size_t(x) * height () + y];
+}
+/*!
+  Returns the minimum value of \a channel, counting the padding zeros.
+ */
+hfloat HilbertPlotBatch::min(std::size_t channel) const
+{
+    checkChannel (channel);
+    return m_min[channel];
+}
+/*!
+  Returns the maximum value of \a channel, counting the padding zeros.
+ */
+hfloat HilbertPlotBatch::max(std::size_t channel) const
+{
+    checkChannel (channel);
+    return m_max[channel];
+}
+/*!
+  Returns the values of every channel, padded to lenght(), scaled to [0, 1]
+  as valueNormalizedAt() does.
+ */
+std::vector<DataSequence> HilbertPlotBatch::normalized() const
+{
+    std::vector<DataSequence> output(m_channels.size ());
+    for_each_chunk_parallel (m_channels.size (), parallel_chunk_count (m_channels.size (), 1),
+                             [&](unsigned long, unsigned long begin, unsigned long end)
+    {
+        for(unsigned long c = begin; c < end; ++c)
+        {
+            hfloat min = m_min[c], max = m_max[c];
+            hfloat scale = min == max ? 0.0 : 1.0 / (max - min);
+            DataSequence values(lenght (), 0.0);
+            for(hsize i = 0; i < lenght (); ++i)
+                values[i] = ((i < m_channels[c].size () ? m_channels[c][i] : 0) - min) * scale;
+            output[c] = std::move(values);
+        }
+    });
+    return output;
+}
+/*!
+  Returns the image of every channel, as HilbertPlot::generateImage() with
+  \a threshold would.
+ */
+std::vector<HImage> HilbertPlotBatch::generateImages(hfloat threshold) const
+{
+    std::vector<HImage> images(m_channels.size ());
+    for_each_chunk_parallel (m_channels.size (), parallel_chunk_count (m_channels.size (), 1),
+                             [&](unsigned long, unsigned long begin, unsigned long end)
+    {
+        for(unsigned long c = begin; c < end; ++c)
+            images[c] = generateImage (c, threshold);
+    });
+    return images;
+}
+/*!
+  Returns the 2D Fourier transform of every channel, as
+  HilbertPlot::hpFourierTransform() with \a logflag would.
+
+  A single FFTW plan is made and then executed on the channels in parallel.
+ */
+std::vector<DataSequence> HilbertPlotBatch::hpFourierTransforms(bool logflag) const
+{
+    if(lenght () == 0) throw HilbertBadOperation();
+    hsize width = this->width ();
+    hsize height = this->height ();
+    std::size_t dataSize = std::size_t(width) * height;
+    std::size_t spectrumSize = std::size_t(height) * (width / 2 + 1) + 2;
+
+    double *planInput = (double*) fftw_malloc(sizeof(double) * dataSize);
+    fftw_complex *planOutput = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * spectrumSize);
+    if(!planInput || !planOutput)
+    {
+        fftw_free(planInput);
+        fftw_free(planOutput);
+        throw HilbertBadAlloc();
+    }
+    fftw_plan plan = fftw_plan_dft_r2c_2d(height, width, planInput, planOutput, FFTW_ESTIMATE);
+
+    std::vector<DataSequence> output(m_channels.size ());
+    std::exception_ptr error;
+    std::mutex mutex;
+    for_each_chunk_parallel (m_channels.size (), parallel_chunk_count (m_channels.size (), 1),
+                             [&](unsigned long, unsigned long begin, unsigned long end)
+    {
+        double *input = (double*) fftw_malloc(sizeof(double) * dataSize);
+        fftw_complex *spectrum = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * spectrumSize);
+        try
+        {
+            if(!input || !spectrum)
+                throw HilbertBadAlloc();
+            for(unsigned long c = begin; c < end; ++c)
+            {
+                const DataView &values = m_channels[c];
+                for(hsize y = 0, i = 0; y < height; ++y)
+                {
+                    for(hsize x = 0; x < width; ++x)
+                    {
+                        hint index = m_plotToCurve[std::size_t(x) * height + y];
+                        input[i++] = index < values.size () ? values[index] : 0;
+                    }
+                }
+                fftw_execute_dft_r2c(plan, input, spectrum);
+                output[c] = arrangeSpectrum (spectrum, width, height, m_plotToCurve, logflag);
+            }
+        }
+        catch (std::bad_alloc& ba)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            error = std::make_exception_ptr(HilbertBadAlloc());
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            error = std::current_exception();
+        }
+        fftw_free(input);
+        fftw_free(spectrum);
+    });
+    fftw_destroy_plan(plan);
+    fftw_free(planInput);
+    fftw_free(planOutput);
+    if(error)
+        std::rethrow_exception(error);
+    return output;
+}
+/*!
+  Returns a standalone HilbertPlot of \a channel. The plot gets its own copy
+  of the curve, while the values are shared.
+ */
+HilbertPlot HilbertPlotBatch::plot(std::size_t channel) const
+{
+    checkChannel (channel);
+    return HilbertPlot(*m_curve, m_channels[channel]);
+}
+
+// Builds the flat inverse curve map and the ranges of every channel.
+void HilbertPlotBatch::initialize()
+{
+    m_plotToCurve.reserve (std::size_t(width ()) * height ());
+    HugePages::advise (m_plotToCurve.data (), m_plotToCurve.capacity ()*sizeof(hint));
+    m_plotToCurve.assign (std::size_t(width ()) * height (), 0);
+    for(const HPoint &point : *m_curve)
+        m_plotToCurve[std::size_t(point.X ()) * height () + point.Y ()] = point.index;
+
+    m_min.assign (m_channels.size (), 0);
+    m_max.assign (m_channels.size (), 0);
+    for_each_chunk_parallel (m_channels.size (), parallel_chunk_count (m_channels.size (), 1),
+                             [&](unsigned long, unsigned long begin, unsigned long end)
+    {
+        for(unsigned long c = begin; c < end; ++c)
+        {
+            const DataView &values = m_channels[c];
+            if(values.empty ())
+                continue;
+            m_min[c] = values.min ();
+            m_max[c] = values.max ();
+            if(values.size () < lenght ())
+            {
+                m_min[c] = std::min(m_min[c], 0.0);
+                m_max[c] = std::max(m_max[c], 0.0);
+            }
+        }
+    });
+}
+
+void HilbertPlotBatch::checkChannel(std::size_t channel) const
+{
+    if(channel >= m_channels.size ())
+        throw HilbertIndexOutOfRange();
+}
+
+HImage HilbertPlotBatch::generateImage(std::size_t channel, hfloat threshold) const
+{
+    hfloat min = m_min[channel], max = m_max[channel];
+    hfloat minmax = max == min ? 0.0 : 1.0/(max - min);
+    const DataView &values = m_channels[channel];
+    HImage image(width (), std::vector<hfloat>(height (), 0));
+    for(const HPoint &point : *m_curve)
+    {
+        hfloat value = point.index < values.size () ? values[point.index] : 0;
+        if(threshold > 0)
+        {
+            value = (value - min) * minmax;
+            if(point.DifferenceValue () / m_curve->meanDifference () > threshold)
+                value = 2;
+        }
+        else
+            value = value * minmax;
+        image[point.X ()][point.Y ()] = value;
+    }
+    return image;
+}
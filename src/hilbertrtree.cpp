@@ -0,0 +1,253 @@
+/*!
+   \headerfile "hilbertrtree.h"
+
+   \title Hilbert R-tree Declaration
+
+   \brief The "hilbertrtree.h" header define HilbertRTree class
+ */
+#include "hilbertrtree.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <tuple>
+
+#include "parallel_algorithm.h"
+
+namespace
+{
+// Squared distance from x, y to the closest point of bounds.
+inline hfloat distance2(const HilbertKey::Bounds &bounds, hfloat x, hfloat y)
+{
+    hfloat dx = x < bounds.minX ? bounds.minX - x : (x > bounds.maxX ? x - bounds.maxX : 0);
+    hfloat dy = y < bounds.minY ? bounds.minY - y : (y > bounds.maxY ? y - bounds.maxY : 0);
+    return dx * dx + dy * dy;
+}
+
+inline bool contains(const HilbertKey::Bounds &rect, hfloat x, hfloat y)
+{
+    return x >= rect.minX && x <= rect.maxX && y >= rect.minY && y <= rect.maxY;
+}
+}
+
+/*!
+   \class HilbertRTree
+   \inmodule hilbertlib
+   \ingroup hcurve
+   \brief The \c HilbertRTree class is a static packed Hilbert R-tree over a
+   set of 2D points.
+
+   The points are sorted by their HilbertKey and packed in leaves of
+   nodeSize() consecutive points, which are grouped the same way level by
+   level up to the root. Since neighbour keys are neighbour points, the nodes
+   are compact and overlap little. The tree is built once, in parallel, and
+   is read-only afterwards, so it can be queried from many threads.
+
+   Rectangle queries decompose the rectangle into key ranges, see
+   HilbertKey::ranges(), and scan the points of each range with binary
+   searches on the sorted keys. Nearest neighbour queries visit the nodes
+   best-first by distance to their bounds.
+
+   Queries return positions of the points in the arrays the tree was built
+   from. Points with NaN coordinates are stored but never found.
+*/
+
+/*!
+  Constructs an empty tree.
+ */
+HilbertRTree::HilbertRTree():
+    m_bounds{0, 0, 0, 0}, m_nodeSize(DEFAULT_RTREE_NODE_SIZE)
+{}
+/*!
+  Constructs the tree of the \a count points with coordinates \a x and \a y,
+  with nodes of \a nodeSize children.
+
+  Throws HilbertBadSize if \a nodeSize is less than two.
+ */
+HilbertRTree::HilbertRTree(const hfloat *x, const hfloat *y, std::size_t count, std::size_t nodeSize):
+    m_bounds(HilbertKey::boundsOf (x, y, count)), m_nodeSize(nodeSize)
+{
+    if(nodeSize < 2)
+        throw HilbertBadSize();
+    try
+    {
+        m_keys.resize (count);
+        m_ids.resize (count);
+        m_x.resize (count);
+        m_y.resize (count);
+    }
+    catch (std::bad_alloc& ba)
+    {
+        throw HilbertBadAlloc();
+    }
+    HilbertKey::fromPoints (x, y, count, m_bounds, m_keys.data ());
+    for(std::size_t i = 0; i < count; ++i)
+        m_ids[i] = i;
+    HilbertKey::sort (m_keys.data (), m_ids.data (), count);
+    for_each_chunk_parallel (count, parallel_chunk_count (count, 1 << 16),
+                             [&](unsigned long, unsigned long begin, unsigned long end)
+    {
+        for(std::size_t i = begin; i < end; ++i)
+        {
+            m_x[i] = x[m_ids[i]];
+            m_y[i] = y[m_ids[i]];
+        }
+    });
+    build ();
+}
+/*!
+  \overload HilbertRTree()
+
+  Constructs the tree of the points with coordinates \a x and \a y.
+
+  Throws HilbertBadSize if the vectors have different sizes.
+ */
+HilbertRTree::HilbertRTree(const std::vector<hfloat> &x, const std::vector<hfloat> &y, std::size_t nodeSize):
+    HilbertRTree(x.data (), y.data (), x.size () == y.size () ? x.size () : throw HilbertBadSize(), nodeSize)
+{}
+/*!
+  Returns the number of points in the tree.
+ */
+std::size_t HilbertRTree::size() const
+{
+    return m_keys.size ();
+}
+/*!
+  Returns the number of children of each node.
+ */
+std::size_t HilbertRTree::nodeSize() const
+{
+    return m_nodeSize;
+}
+/*!
+  Returns the bounds of all the points.
+ */
+const HilbertRTree::Bounds &HilbertRTree::bounds() const
+{
+    return m_bounds;
+}
+/*!
+  Returns the positions of the points inside \a rect, borders included,
+  in curve order.
+ */
+std::vector<std::size_t> HilbertRTree::query(const Bounds &rect) const
+{
+    std::vector<std::size_t> output;
+    if(m_keys.empty () || rect.minX > m_bounds.maxX || rect.maxX < m_bounds.minX ||
+       rect.minY > m_bounds.maxY || rect.maxY < m_bounds.minY)
+        return output;
+
+    uint32_t minX = HilbertKey::quantize (rect.minX, m_bounds.minX, m_bounds.maxX);
+    uint32_t maxX = HilbertKey::quantize (rect.maxX, m_bounds.minX, m_bounds.maxX);
+    uint32_t minY = HilbertKey::quantize (rect.minY, m_bounds.minY, m_bounds.maxY);
+    uint32_t maxY = HilbertKey::quantize (rect.maxY, m_bounds.minY, m_bounds.maxY);
+    auto first = m_keys.begin ();
+    for(const HilbertKey::Range &range : HilbertKey::ranges (minX, minY, maxX, maxY))
+    {
+        first = std::lower_bound(first, m_keys.end (), range.first);
+        for(; first != m_keys.end () && *first <= range.second; ++first)
+        {
+            std::size_t i = first - m_keys.begin ();
+            if(contains (rect, m_x[i], m_y[i]))
+                output.push_back (m_ids[i]);
+        }
+    }
+    return output;
+}
+/*!
+  Returns the positions of the \a k points closest to \a x, \a y, nearest
+  first. Ties are broken by curve order.
+ */
+std::vector<std::size_t> HilbertRTree::nearest(hfloat x, hfloat y, std::size_t k) const
+{
+    std::vector<std::size_t> output;
+    if(m_keys.empty () || k == 0)
+        return output;
+
+    // Entries are (distance, level, index). Level -1 holds points, which come
+    // out before nodes at the same distance.
+    typedef std::tuple<hfloat, int, std::size_t> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    int top = int(m_levels.size ()) - 1;
+    for(std::size_t i = 0; i < m_levels[top].size (); ++i)
+        queue.push (Entry(distance2 (m_levels[top][i], x, y), top, i));
+
+    while(!queue.empty () && output.size () < k)
+    {
+        Entry entry = queue.top ();
+        queue.pop ();
+        int level = std::get<1>(entry);
+        std::size_t index = std::get<2>(entry);
+        if(level < 0)
+        {
+            output.push_back (m_ids[index]);
+            continue;
+        }
+        std::size_t first = index * m_nodeSize;
+        if(level == 0)
+        {
+            std::size_t last = std::min(first + m_nodeSize, m_keys.size ());
+            for(std::size_t i = first; i < last; ++i)
+            {
+                hfloat dx = m_x[i] - x, dy = m_y[i] - y;
+                hfloat d = dx * dx + dy * dy;
+                if(!std::isnan(d))
+                    queue.push (Entry(d, -1, i));
+            }
+        }
+        else
+        {
+            const std::vector<Bounds> &children = m_levels[level - 1];
+            std::size_t last = std::min(first + m_nodeSize, children.size ());
+            for(std::size_t i = first; i < last; ++i)
+                queue.push (Entry(distance2 (children[i], x, y), level - 1, i));
+        }
+    }
+    return output;
+}
+
+// Packs the sorted points in leaves and the nodes of each level in parents,
+// until a level fits in one node.
+void HilbertRTree::build()
+{
+    m_levels.clear ();
+    std::size_t count = m_keys.size ();
+    if(count == 0)
+        return;
+    const hfloat inf = std::numeric_limits<hfloat>::infinity();
+    const Bounds empty{inf, inf, -inf, -inf};
+
+    std::vector<Bounds> leaves((count + m_nodeSize - 1) / m_nodeSize, empty);
+    for_each_chunk_parallel (leaves.size (), parallel_chunk_count (leaves.size (), 1024),
+                             [&](unsigned long, unsigned long begin, unsigned long end)
+    {
+        for(std::size_t node = begin; node < end; ++node)
+        {
+            Bounds &bounds = leaves[node];
+            std::size_t last = std::min((node + 1) * m_nodeSize, count);
+            for(std::size_t i = node * m_nodeSize; i < last; ++i)
+            {
+                bounds.minX = std::min(bounds.minX, m_x[i]);
+                bounds.maxX = std::max(bounds.maxX, m_x[i]);
+                bounds.minY = std::min(bounds.minY, m_y[i]);
+                bounds.maxY = std::max(bounds.maxY, m_y[i]);
+            }
+        }
+    });
+    m_levels.push_back (std::move(leaves));
+
+    while(m_levels.back ().size () > m_nodeSize)
+    {
+        const std::vector<Bounds> &children = m_levels.back ();
+        std::vector<Bounds> parents((children.size () + m_nodeSize - 1) / m_nodeSize, empty);
+        for(std::size_t i = 0; i < children.size (); ++i)
+        {
+            Bounds &bounds = parents[i / m_nodeSize];
+            bounds.minX = std::min(bounds.minX, children[i].minX);
+            bounds.maxX = std::max(bounds.maxX, children[i].maxX);
+            bounds.minY = std::min(bounds.minY, children[i].minY);
+            bounds.maxY = std::max(bounds.maxY, children[i].maxY);
+        }
+        m_levels.push_back (std::move(parents));
+    }
+}
@@ -0,0 +1,280 @@
+/*!
+   \headerfile "hugepages.h"
+
+   \title Huge Pages Declaration
+
+   \brief The "hugepages.h" header define HugePages and HugePageResource classes
+ */
+#include "hugepages.h"
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+#if defined(__linux__)
+#define HILBERT_HAS_THP
+#include <sys/mman.h>
+#endif
+
+namespace
+{
+std::atomic<bool> hugePagesEnabled(true);
+std::atomic<std::size_t> hugePageThreshold(DEFAULT_HUGE_PAGE_THRESHOLD);
+
+// Mappings made by HugePageResource, by address, with their lenght.
+std::mutex mappingsMutex;
+std::map<void *, std::size_t> mappings;
+
+std::uintptr_t roundUp(std::uintptr_t value, std::size_t multiple)
+{
+    return (value + multiple - 1) / multiple * multiple;
+}
+}
+
+/*!
+   \class HugePages
+   \inmodule hilbertlib
+   \ingroup hdata
+   \brief The \c HugePages class controls the use of transparent huge pages
+   for large library buffers.
+
+   Buffers of hundreds of megabytes walked with strided or scattered accesses,
+   like the curve sorted in HilbertCurve::BuildDifference() or the inverse
+   maps of a plot, miss the TLB on almost every access with 4 KB pages. Backing
+   them with 2 MB pages removes most of those misses.
+
+   Buffers of at least threshold() bytes are advised to the kernel with
+   \c madvise(MADV_HUGEPAGE), either after being reserved, see advise(), or
+   when allocated from a HugePageResource, which maps them 2 MB aligned. The
+   kernel may still back them with small pages; obtained() reads from
+   \c /proc/self/smaps how many bytes actually got huge pages.
+
+   The settings are global. Huge pages are only available on Linux with
+   transparent huge pages set to \c always or \c madvise; elsewhere these
+   functions do nothing.
+*/
+
+/*!
+  Returns \c true if the system can give transparent huge pages on request.
+ */
+bool HugePages::isSupported()
+{
+#ifdef HILBERT_HAS_THP
+    std::ifstream input("/sys/kernel/mm/transparent_hugepage/enabled");
+    std::string mode((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    return mode.find ("[always]") != std::string::npos || mode.find ("[madvise]") != std::string::npos;
+#else
+    return false;
+#endif
+}
+/*!
+  Returns \c true if large buffers ask for huge pages, the default.
+ */
+bool HugePages::enabled()
+{
+    return hugePagesEnabled;
+}
+/*!
+  Sets whether large buffers ask for huge pages to \a enabled.
+ */
+void HugePages::setEnabled(bool enabled)
+{
+    hugePagesEnabled = enabled;
+}
+/*!
+  Returns the size in bytes from which buffers ask for huge pages. It's
+  DEFAULT_HUGE_PAGE_THRESHOLD (32 MB) by default.
+ */
+std::size_t HugePages::threshold()
+{
+    return hugePageThreshold;
+}
+/*!
+  Sets the size in bytes from which buffers ask for huge pages to \a bytes.
+ */
+void HugePages::setThreshold(std::size_t bytes)
+{
+    hugePageThreshold = bytes;
+}
+/*!
+  Asks for huge pages for the \a bytes at \a data, if they are enabled and
+  \a bytes reaches the threshold. Only the 2 MB aligned pages inside the
+  buffer can get them, and only for the pages not touched yet, so it's best
+  called right after reserving the buffer.
+
+  Returns \c true if the advice was given.
+ */
+bool HugePages::advise(const void *data, std::size_t bytes)
+{
+#ifdef HILBERT_HAS_THP
+    if(!enabled () || !data || bytes < threshold ())
+        return false;
+    std::uintptr_t first = roundUp (reinterpret_cast<std::uintptr_t>(data), HUGE_PAGE_SIZE);
+    std::uintptr_t last = (reinterpret_cast<std::uintptr_t>(data) + bytes) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    if(last <= first)
+        return false;
+    return madvise (reinterpret_cast<void *>(first), last - first, MADV_HUGEPAGE) == 0;
+#else
+    (void)data;
+    (void)bytes;
+    return false;
+#endif
+}
+/*!
+  Returns how many of the \a bytes at \a data are backed by huge pages, as
+  reported by the \c AnonHugePages field of \c /proc/self/smaps for the
+  mappings holding them.
+ */
+std::size_t HugePages::obtained(const void *data, std::size_t bytes)
+{
+    std::size_t total = 0;
+#ifdef HILBERT_HAS_THP
+    std::uintptr_t first = reinterpret_cast<std::uintptr_t>(data);
+    std::uintptr_t last = first + bytes;
+    std::ifstream smaps("/proc/self/smaps");
+    std::string line;
+    std::size_t overlap = 0;
+    while(std::getline (smaps, line))
+    {
+        std::size_t dash = line.find ('-');
+        std::size_t space = line.find (' ');
+        if(dash != std::string::npos && space != std::string::npos && dash < space &&
+           line.find (':') > space)
+        {
+            // Mapping header: "start-end perms offset device inode path"
+            std::uintptr_t start = std::stoull (line.substr (0, dash), nullptr, 16);
+            std::uintptr_t end = std::stoull (line.substr (dash + 1, space - dash - 1), nullptr, 16);
+            overlap = start < last && end > first ? std::min(end, last) - std::max(start, first) : 0;
+        }
+        else if(overlap > 0 && line.compare (0, 14, "AnonHugePages:") == 0)
+        {
+            std::istringstream field(line.substr (14));
+            std::size_t kilobytes = 0;
+            field >> kilobytes;
+            total += std::min(kilobytes * 1024, overlap);
+        }
+    }
+#else
+    (void)data;
+    (void)bytes;
+#endif
+    return total;
+}
+/*!
+  \overload obtained()
+
+  Returns how many bytes of the whole process are backed by transparent huge
+  pages.
+ */
+std::size_t HugePages::obtained()
+{
+    std::size_t total = 0;
+#ifdef HILBERT_HAS_THP
+    std::ifstream smaps("/proc/self/smaps");
+    std::string line;
+    while(std::getline (smaps, line))
+    {
+        if(line.compare (0, 14, "AnonHugePages:") == 0)
+        {
+            std::istringstream field(line.substr (14));
+            std::size_t kilobytes = 0;
+            field >> kilobytes;
+            total += kilobytes * 1024;
+        }
+    }
+#endif
+    return total;
+}
+
+/*!
+   \class HugePageResource
+   \inmodule hilbertlib
+   \brief The \c HugePageResource class is a MemoryResource that backs large
+   allocations with huge pages.
+
+   Allocations of at least HugePages::threshold() bytes are mapped on their
+   own, aligned to 2 MB and advised with \c MADV_HUGEPAGE, so every page of
+   them can be a huge page. Smaller ones, or all of them when huge pages are
+   disabled or unsupported, come from the upstream resource.
+*/
+
+/*!
+  Constructs the resource, taking small allocations from \a upstream.
+ */
+HugePageResource::HugePageResource(MemoryResource *upstream):
+    m_upstream(upstream ? upstream : MemoryResource::defaultResource ()),
+    m_hugeBytes(0)
+{}
+/*!
+  Returns the bytes currently mapped for huge pages, see
+  HugePages::obtained() for how many got them.
+ */
+std::size_t HugePageResource::hugeBytes() const
+{
+    return m_hugeBytes;
+}
+/*!
+  Returns a resource shared by the whole program.
+ */
+HugePageResource *HugePageResource::instance()
+{
+    static HugePageResource resource;
+    return &resource;
+}
+
+void *HugePageResource::doAllocate(std::size_t bytes, std::size_t alignment)
+{
+#ifdef HILBERT_HAS_THP
+    if(HugePages::enabled () && bytes >= HugePages::threshold () && alignment <= HUGE_PAGE_SIZE)
+    {
+        std::size_t lenght = roundUp (bytes, HUGE_PAGE_SIZE);
+        void *reserved = mmap (nullptr, lenght + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(reserved != MAP_FAILED)
+        {
+            // Trim the reservation to a 2 MB aligned range.
+            char *base = static_cast<char *>(reserved);
+            char *aligned = reinterpret_cast<char *>(roundUp (reinterpret_cast<std::uintptr_t>(base), HUGE_PAGE_SIZE));
+            if(aligned > base)
+                munmap (base, aligned - base);
+            if(aligned + lenght < base + lenght + HUGE_PAGE_SIZE)
+                munmap (aligned + lenght, base + lenght + HUGE_PAGE_SIZE - (aligned + lenght));
+            madvise (aligned, lenght, MADV_HUGEPAGE);
+            try
+            {
+                std::lock_guard<std::mutex> lock(mappingsMutex);
+                mappings[aligned] = lenght;
+            }
+            catch (std::bad_alloc& ba)
+            {
+                munmap (aligned, lenght);
+                throw HilbertBadAlloc();
+            }
+            m_hugeBytes += lenght;
+            return aligned;
+        }
+    }
+#endif
+    return m_upstream->allocate (bytes, alignment);
+}
+
+void HugePageResource::doDeallocate(void *pointer, std::size_t bytes, std::size_t alignment)
+{
+#ifdef HILBERT_HAS_THP
+    {
+        std::lock_guard<std::mutex> lock(mappingsMutex);
+        auto mapping = mappings.find (pointer);
+        if(mapping != mappings.end ())
+        {
+            munmap (pointer, mapping->second);
+            m_hugeBytes -= mapping->second;
+            mappings.erase (mapping);
+            return;
+        }
+    }
+#endif
+    m_upstream->deallocate (pointer, bytes, alignment);
+}
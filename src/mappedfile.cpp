@@ -0,0 +1,262 @@
+/*!
+   \headerfile "mappedfile.h"
+
+   \title Mapped File Declaration
+
+   \brief The "mappedfile.h" header define MappedFile class
+ */
+#include "mappedfile.h"
+#include <algorithm>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define HILBERT_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*!
+   \class MappedFile
+   \inmodule hilbertlib
+   \brief The \c MappedFile class gives read-only access to a file, or a range
+   of it, in memory.
+
+   On POSIX systems the file is mapped with \c mmap, so its pages are loaded on
+   demand and shared with the page cache. On other systems the file is read
+   into an internal buffer. In both cases data() stays valid while the object
+   is alive.
+
+   \note HilbertIOError exception is thrown if the file can't be opened or mapped.
+*/
+
+/*!
+  Constructs an empty mapping.
+*/
+MappedFile::MappedFile():
+    m_data(nullptr), m_size(0), m_mapped(false), m_mapOffset(0)
+{}
+/*!
+  Maps the file at \a path.
+*/
+MappedFile::MappedFile(const std::string &path):
+    m_data(nullptr), m_size(0), m_mapped(false), m_mapOffset(0)
+{
+    map (path, 0, fileSize (path));
+}
+/*!
+  Maps \a lenght bytes of the file at \a path starting at \a offset. The
+  range is clamped to the end of the file.
+*/
+MappedFile::MappedFile(const std::string &path, std::size_t offset, std::size_t lenght):
+    m_data(nullptr), m_size(0), m_mapped(false), m_mapOffset(0)
+{
+    std::size_t size = fileSize (path);
+    if(offset > size)
+        throw HilbertIOError();
+    map (path, offset, std::min(lenght, size - offset));
+}
+/*!
+  Move constructor. Transfers the mapping of \a other.
+*/
+MappedFile::MappedFile(MappedFile &&other):
+    m_data(other.m_data), m_size(other.m_size), m_mapped(other.m_mapped),
+    m_mapOffset(other.m_mapOffset), m_buffer(std::move(other.m_buffer))
+{
+    other.m_data = nullptr;
+    other.m_size = 0;
+    other.m_mapped = false;
+    other.m_mapOffset = 0;
+}
+/*!
+  Unmaps the file.
+*/
+MappedFile::~MappedFile()
+{
+    unmap ();
+}
+/*!
+  Move assignment. Transfers the mapping of \a other.
+*/
+MappedFile &MappedFile::operator=(MappedFile &&other)
+{
+    if(this != &other)
+    {
+        unmap ();
+        m_data = other.m_data;
+        m_size = other.m_size;
+        m_mapped = other.m_mapped;
+        m_mapOffset = other.m_mapOffset;
+        m_buffer = std::move(other.m_buffer);
+        other.m_data = nullptr;
+        other.m_size = 0;
+        other.m_mapped = false;
+        other.m_mapOffset = 0;
+    }
+    return *this;
+}
+/*!
+  Returns a pointer to the file contents.
+*/
+const char *MappedFile::data() const
+{
+    return m_data;
+}
+/*!
+  Returns the file size in bytes.
+*/
+std::size_t MappedFile::size() const
+{
+    return m_size;
+}
+/*!
+  Returns \c true if the file is memory mapped, \c false if it was read into a buffer.
+*/
+bool MappedFile::isMapped() const
+{
+    return m_mapped;
+}
+/*!
+  Gives the kernel an \a advice about the access pattern for \a lenght bytes
+  starting at \a offset. It's a hint only, does nothing on buffered files.
+*/
+void MappedFile::advise(std::size_t offset, std::size_t lenght, Advice advice) const
+{
+#ifdef HILBERT_HAS_MMAP
+    if(!m_mapped || offset >= m_size)
+        return;
+    std::size_t page = pageSize ();
+    std::size_t begin = (m_mapOffset + offset) / page * page;
+    std::size_t end = m_mapOffset + std::min(m_size, offset + lenght);
+    int flag = MADV_NORMAL;
+    switch (advice)
+    {
+        case Normal: flag = MADV_NORMAL; break;
+        case Sequential: flag = MADV_SEQUENTIAL; break;
+        case Random: flag = MADV_RANDOM; break;
+        case WillNeed: flag = MADV_WILLNEED; break;
+        case DontNeed: flag = MADV_DONTNEED; break;
+    }
+    ::madvise(const_cast<char *>(m_data) - m_mapOffset + begin, end - begin, flag);
+#else
+    (void)offset; (void)lenght; (void)advice;
+#endif
+}
+/*!
+  Returns the system memory page size.
+*/
+std::size_t MappedFile::pageSize()
+{
+#ifdef HILBERT_HAS_MMAP
+    static const std::size_t size = ::sysconf(_SC_PAGESIZE);
+    return size;
+#else
+    return 4096;
+#endif
+}
+/*!
+  Returns the size in bytes of the file at \a path.
+  \note HilbertIOError exception is thrown if the file can't be opened.
+*/
+std::size_t MappedFile::fileSize(const std::string &path)
+{
+#ifdef HILBERT_HAS_MMAP
+    struct stat info;
+    if(::stat(path.c_str (), &info) != 0)
+        throw HilbertIOError();
+    return info.st_size;
+#else
+    std::ifstream input(path.c_str (), std::ios::binary | std::ios::ate);
+    if(!input)
+        throw HilbertIOError();
+    return static_cast<std::size_t>(input.tellg());
+#endif
+}
+/*!
+  Gives the kernel an \a advice about \a lenght bytes at \a offset of the file
+  at \a path, whether it's mapped or not. WillNeed starts reading the range
+  into the page cache in background and returns immediately, so it's used to
+  read ahead before mapping. It's a hint only, does nothing where
+  \c posix_fadvise isn't available.
+*/
+void MappedFile::adviseFile(const std::string &path, std::size_t offset, std::size_t lenght, Advice advice)
+{
+#if defined(HILBERT_HAS_MMAP) && defined(POSIX_FADV_WILLNEED)
+    int fd = ::open(path.c_str (), O_RDONLY);
+    if(fd < 0)
+        return;
+    int flag = POSIX_FADV_NORMAL;
+    switch (advice)
+    {
+        case Normal: flag = POSIX_FADV_NORMAL; break;
+        case Sequential: flag = POSIX_FADV_SEQUENTIAL; break;
+        case Random: flag = POSIX_FADV_RANDOM; break;
+        case WillNeed: flag = POSIX_FADV_WILLNEED; break;
+        case DontNeed: flag = POSIX_FADV_DONTNEED; break;
+    }
+    ::posix_fadvise(fd, offset, lenght, flag);
+    ::close(fd);
+#else
+    (void)path; (void)offset; (void)lenght; (void)advice;
+#endif
+}
+/*!
+  Maps \a lenght bytes of the file at \a path starting at \a offset. The
+  mapping starts at the page holding \a offset, data() points to \a offset.
+*/
+void MappedFile::map(const std::string &path, std::size_t offset, std::size_t lenght)
+{
+#ifdef HILBERT_HAS_MMAP
+    int fd = ::open(path.c_str (), O_RDONLY);
+    if(fd < 0)
+        throw HilbertIOError();
+    if(lenght > 0)
+    {
+        std::size_t start = offset / pageSize () * pageSize ();
+        void *address = ::mmap(nullptr, lenght + offset - start, PROT_READ, MAP_PRIVATE, fd, start);
+        if(address == MAP_FAILED)
+        {
+            ::close(fd);
+            throw HilbertIOError();
+        }
+        m_mapOffset = offset - start;
+        m_data = static_cast<const char *>(address) + m_mapOffset;
+        m_size = lenght;
+        m_mapped = true;
+    }
+    ::close(fd);
+#else
+    std::ifstream input(path.c_str (), std::ios::binary);
+    if(!input)
+        throw HilbertIOError();
+    input.seekg(offset, input.beg);
+    try
+    {
+        m_buffer.resize (lenght);
+    }
+    catch (std::bad_alloc& ba)
+    {
+        throw HilbertBadAlloc();
+    }
+    input.read(m_buffer.data (), lenght);
+    m_data = m_buffer.data ();
+    m_size = m_buffer.size ();
+#endif
+}
+/*!
+  Release the mapping or the buffer.
+*/
+void MappedFile::unmap()
+{
+#ifdef HILBERT_HAS_MMAP
+    if(m_mapped)
+        ::munmap(const_cast<char *>(m_data) - m_mapOffset, m_size + m_mapOffset);
+#endif
+    m_buffer.clear ();
+    m_buffer.shrink_to_fit ();
+    m_data = nullptr;
+    m_size = 0;
+    m_mapped = false;
+    m_mapOffset = 0;
+}
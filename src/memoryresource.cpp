@@ -0,0 +1,264 @@
+/*!
+   \headerfile "memoryresource.h"
+
+   \title Memory Resource Declaration
+
+   \brief The "memoryresource.h" header define MemoryResource class and the
+   allocators using it.
+ */
+#include "memoryresource.h"
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+namespace
+{
+thread_local MemoryResource *currentResource = nullptr;
+
+inline char *alignUp(char *pointer, std::size_t alignment)
+{
+    std::uintptr_t address = reinterpret_cast<std::uintptr_t>(pointer);
+    return pointer + (alignment - address % alignment) % alignment;
+}
+}
+
+/*!
+   \class MemoryResource
+   \inmodule hilbertlib
+   \ingroup hdata
+   \brief The \c MemoryResource class is the interface of the memory sources
+   used by the library buffers.
+
+   Resources hand out memory aligned to at least HILBERT_ALIGNMENT (64) bytes,
+   a cache line and the widest SIMD register, and keep statistics of the bytes
+   and calls to allocate and free, see stats().
+
+   Containers use a resource through ResourceAllocator, for example an
+   AlignedVector. A default constructed allocator takes defaultResource(), so
+   containers that outlive a Scope never point into a released arena.
+   Temporaries that should follow the current resource of the thread, which
+   is defaultResource() unless a Scope selects another one, pass current()
+   to their allocator explicitly, as the curve construction does. A Scope
+   with an ArenaResource gives an operation a private arena for its
+   temporaries, released at once when the operation ends, and reports what
+   was allocated while it was active.
+
+   \code
+   ArenaResource arena;
+   {
+       MemoryResource::Scope scope(&arena);
+       HilbertCurve curve(1024, 1024, HilbertCurve::H3);
+       MemoryStats used = scope.stats ();
+   }
+   \endcode
+*/
+
+/*!
+   \class MemoryStats
+   \inmodule hilbertlib
+   \brief The \c MemoryStats struct counts the bytes and calls that allocated
+   and freed memory from a MemoryResource.
+*/
+
+/*!
+   \class MemoryResource::Scope
+   \inmodule hilbertlib
+   \brief The \c Scope class makes a resource the current one of the thread
+   while it exists.
+
+   Scopes nest: the previous resource is restored when the scope is
+   destroyed. Tasks the library spreads to other threads inherit the resource
+   of the thread that started them.
+*/
+
+/*!
+  Makes \a resource the current one of the calling thread. A null
+  \a resource selects defaultResource().
+ */
+MemoryResource::Scope::Scope(MemoryResource *resource):
+    m_resource(resource ? resource : MemoryResource::defaultResource ()),
+    m_previous(currentResource),
+    m_start(m_resource->stats ())
+{
+    currentResource = m_resource;
+}
+/*!
+  Restores the resource that was current before the scope.
+ */
+MemoryResource::Scope::~Scope()
+{
+    currentResource = m_previous;
+}
+/*!
+  Returns the resource selected by the scope.
+ */
+MemoryResource *MemoryResource::Scope::resource() const
+{
+    return m_resource;
+}
+/*!
+  Returns what was allocated and freed from the resource since the scope
+  began, including other threads using the same resource.
+ */
+MemoryStats MemoryResource::Scope::stats() const
+{
+    MemoryStats now = m_resource->stats ();
+    return MemoryStats{now.bytesAllocated - m_start.bytesAllocated, now.bytesFreed - m_start.bytesFreed,
+                       now.allocations - m_start.allocations, now.deallocations - m_start.deallocations};
+}
+
+MemoryResource::MemoryResource():
+    m_bytesAllocated(0), m_bytesFreed(0), m_allocations(0), m_deallocations(0)
+{}
+
+MemoryResource::~MemoryResource()
+{}
+/*!
+  Returns \a bytes of memory aligned to \a alignment, which must be a power
+  of two.
+
+  Throws HilbertBadAlloc if the memory can't be obtained.
+ */
+void *MemoryResource::allocate(std::size_t bytes, std::size_t alignment)
+{
+    void *pointer = doAllocate (bytes, std::max(alignment, HILBERT_ALIGNMENT));
+    m_bytesAllocated += bytes;
+    ++m_allocations;
+    return pointer;
+}
+/*!
+  Frees the memory at \a pointer, obtained from allocate() with the same
+  \a bytes and \a alignment.
+ */
+void MemoryResource::deallocate(void *pointer, std::size_t bytes, std::size_t alignment)
+{
+    if(!pointer)
+        return;
+    doDeallocate (pointer, bytes, std::max(alignment, HILBERT_ALIGNMENT));
+    m_bytesFreed += bytes;
+    ++m_deallocations;
+}
+/*!
+  Returns the bytes and calls allocated and freed since the resource was
+  created.
+ */
+MemoryStats MemoryResource::stats() const
+{
+    return MemoryStats{m_bytesAllocated.load (), m_bytesFreed.load (), m_allocations.load (),
+                       m_deallocations.load ()};
+}
+/*!
+  Returns the resource used by default, an AlignedResource shared by the
+  whole program.
+ */
+MemoryResource *MemoryResource::defaultResource()
+{
+    static AlignedResource resource;
+    return &resource;
+}
+/*!
+  Returns the current resource of the calling thread.
+  \sa Scope
+ */
+MemoryResource *MemoryResource::current()
+{
+    return currentResource ? currentResource : defaultResource ();
+}
+
+/*!
+   \class AlignedResource
+   \inmodule hilbertlib
+   \brief The \c AlignedResource class takes aligned memory from the global
+   heap.
+*/
+
+void *AlignedResource::doAllocate(std::size_t bytes, std::size_t alignment)
+{
+    char *raw;
+    try
+    {
+        raw = static_cast<char *>(::operator new(bytes + alignment + sizeof(void *)));
+    }
+    catch (std::bad_alloc& ba)
+    {
+        throw HilbertBadAlloc();
+    }
+    char *pointer = alignUp (raw + sizeof(void *), alignment);
+    reinterpret_cast<void **>(pointer)[-1] = raw;
+    return pointer;
+}
+
+void AlignedResource::doDeallocate(void *pointer, std::size_t, std::size_t)
+{
+    ::operator delete(reinterpret_cast<void **>(pointer)[-1]);
+}
+
+/*!
+   \class ArenaResource
+   \inmodule hilbertlib
+   \brief The \c ArenaResource class hands out memory from large blocks and
+   frees it all at once.
+
+   Allocating is a pointer increment in the current block and freeing does
+   nothing, so the many small temporaries of an operation cost almost no
+   time. The blocks, taken from an upstream resource, are returned by
+   release() or when the arena is destroyed, which invalidates all the
+   memory it gave. It can be shared by several threads.
+*/
+
+/*!
+  Constructs an arena that takes blocks of at least \a blockSize bytes from
+  \a upstream.
+ */
+ArenaResource::ArenaResource(std::size_t blockSize, MemoryResource *upstream):
+    m_blockSize(std::max<std::size_t>(blockSize, HILBERT_ALIGNMENT)),
+    m_upstream(upstream ? upstream : MemoryResource::defaultResource ()),
+    m_cursor(nullptr), m_end(nullptr)
+{}
+
+ArenaResource::~ArenaResource()
+{
+    release ();
+}
+/*!
+  Returns all the blocks to the upstream resource.
+ */
+void ArenaResource::release()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for(const Block &block : m_blocks)
+        m_upstream->deallocate (block.data, block.size);
+    m_blocks.clear ();
+    m_cursor = m_end = nullptr;
+}
+/*!
+  Returns the bytes of the blocks held by the arena.
+ */
+std::size_t ArenaResource::capacity() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::size_t total = 0;
+    for(const Block &block : m_blocks)
+        total += block.size;
+    return total;
+}
+
+void *ArenaResource::doAllocate(std::size_t bytes, std::size_t alignment)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    char *pointer = m_cursor ? alignUp (m_cursor, alignment) : nullptr;
+    if(!pointer || pointer > m_end || std::size_t(m_end - pointer) < bytes)
+    {
+        std::size_t size = std::max(m_blockSize, bytes + alignment);
+        Block block{static_cast<char *>(m_upstream->allocate (size)), size};
+        m_blocks.push_back (block);
+        m_end = block.data + block.size;
+        pointer = alignUp (block.data, alignment);
+    }
+    m_cursor = pointer + bytes;
+    return pointer;
+}
+
+void ArenaResource::doDeallocate(void *, std::size_t, std::size_t)
+{
+}
@@ -0,0 +1,117 @@
+/*!
+   \headerfile "plotloader.h"
+
+   \title Plot Loader Declaration
+
+   \brief The "plotloader.h" header define PlotLoader class
+ */
+#include "plotloader.h"
+#include <limits>
+#include <memory>
+
+#include "dataview.h"
+#include "mappedfile.h"
+#include "numberparser.h"
+
+namespace
+{
+// Starts fetching the curve for count values, computing the best dimensions
+// if width or height are zero.
+std::shared_future<CurveCache::CurvePointer> startCurve(CurveCache &cache, std::size_t count, hsize &width,
+                                                        hsize &height, HilbertCurve::CurveType type)
+{
+    if(width == 0 || height == 0)
+    {
+        hsize lenght = count > std::numeric_limits<hsize>::max () ? std::numeric_limits<hsize>::max () : count;
+        auto dim = HilbertPlot::bestDimensions (lenght);
+        width = dim.first;
+        height = dim.second;
+    }
+    return cache.curveAsync (width, height, type);
+}
+}
+
+/*!
+   \class PlotLoader
+   \inmodule hilbertlib
+   \ingroup hdata
+   \brief The \c PlotLoader class loads files directly into a HilbertPlot,
+   building the curve while the data is read.
+
+   The plot dimensions only depend on the amount of values. For binary files
+   it follows from the file size, and for plain text from a quick count of the
+   numbers, much faster than parsing them. As soon as it's known the curve is
+   requested to a CurveCache, which builds it in background or returns it at
+   once if it was already built, while the values are loaded on the calling
+   thread. The time to get the plot is then the longest of both instead of
+   their sum.
+
+   The plots are the same as constructing a HilbertPlot from the loaded data
+   with the same arguments.
+*/
+
+/*!
+  Returns the plot of the raw binary file at \a path holding samples of
+  \a type with \a order byte order after \a offset header bytes, see
+  BinaryLoader::fromRaw(). The plot has \a width x \a height cells, or the best
+  dimensions if any is zero, along a curve of \a curveType taken from \a cache.
+*/
+HilbertPlot PlotLoader::fromRaw(const std::string &path, BinaryLoader::SampleType type,
+                                BinaryLoader::ByteOrder order, std::size_t offset,
+                                hsize width, hsize height, HilbertCurve::CurveType curveType, CurveCache &cache)
+{
+    std::size_t bytes = MappedFile::fileSize (path);
+    if(offset > bytes)
+        throw HilbertIOError();
+    std::size_t count = (bytes - offset) / BinaryLoader::sampleSize (type);
+    auto curve = startCurve (cache, count, width, height, curveType);
+    DataView data = BinaryLoader::fromRaw (path, type, order, offset);
+    return HilbertPlot(*curve.get (), data);
+}
+/*!
+  Returns the plot of the NumPy file at \a path, see BinaryLoader::fromNpy(). The
+  plot has \a width x \a height cells, or the best dimensions if any is zero,
+  along a curve of \a curveType taken from \a cache.
+*/
+HilbertPlot PlotLoader::fromNpy(const std::string &path, hsize width, hsize height,
+                                HilbertCurve::CurveType curveType, CurveCache &cache)
+{
+    std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>(path);
+    BinaryLoader::NpyHeader header = BinaryLoader::readNpyHeader (file->data (), file->size ());
+    std::size_t bytes = header.elements * BinaryLoader::sampleSize (header.type);
+    if(file->size () - header.dataOffset < bytes)
+        throw HilbertIOError();
+    auto curve = startCurve (cache, header.elements, width, height, curveType);
+    file->advise (header.dataOffset, bytes, MappedFile::Sequential);
+    DataView data = BinaryLoader::fromRaw (file->data () + header.dataOffset, bytes, header.type, header.order, file);
+    return HilbertPlot(*curve.get (), data);
+}
+/*!
+  Returns the plot of the numbers in the plain text file at \a path, see
+  DataSequence::fromPlainTextFile(). The plot has \a width x \a height cells,
+  or the best dimensions if any is zero, along a curve of \a curveType taken
+  from \a cache.
+
+  When the dimensions are computed, the curve is started from the count given
+  by NumberParser::countNumbers(). If malformed text makes the parsed values
+  differ from that count, the right curve is fetched after parsing.
+*/
+HilbertPlot PlotLoader::fromPlainTextFile(const std::string &path, hsize width, hsize height,
+                                          HilbertCurve::CurveType curveType, CurveCache &cache)
+{
+    MappedFile file(path);
+    file.advise (0, file.size (), MappedFile::Sequential);
+    const char *first = file.data ();
+    const char *last = first + file.size ();
+
+    bool estimated = width == 0 || height == 0;
+    std::size_t count = estimated ? NumberParser::countNumbers (first, last) : 0;
+    auto curve = startCurve (cache, count, width, height, curveType);
+    DataSequence data = DataSequence::fromPlainText (first, last);
+    if(estimated && data.size () != count)
+    {
+        width = height = 0;
+        curve = startCurve (cache, data.size (), width, height, curveType);
+    }
+    return HilbertPlot(*curve.get (), std::move(data));
+}
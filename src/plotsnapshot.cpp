@@ -0,0 +1,369 @@
+/*!
+   \headerfile "plotsnapshot.h"
+
+   \title Plot Snapshot Declaration
+
+   \brief The "plotsnapshot.h" header define PlotSnapshot class
+ */
+#include "plotsnapshot.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <vector>
+#include "hugepages.h"
+#include "mappedfile.h"
+#include "parallel_algorithm.h"
+
+namespace
+{
+const char SNAPSHOT_MAGIC[8] = {'H', 'P', 'L', 'O', 'T', 'S', 'N', 'P'};
+const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+const std::size_t SNAPSHOT_ALIGNMENT = 64;
+const std::size_t SNAPSHOT_BLOCK_SIZE = 1 << 16;
+
+// Sections are stored in this order, each one starting at a multiple of
+// SNAPSHOT_ALIGNMENT so they can be used in place when the file is mapped.
+struct FileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t sections;
+    uint32_t type;
+    uint32_t aggregation;
+    uint32_t width;
+    uint32_t height;
+    uint32_t reserved;
+    uint64_t values;
+    double min;
+    double max;
+    double meanDifference;
+    uint64_t dataOffset;
+    uint64_t curveOffset;
+    uint64_t differenceOffset;
+    uint64_t inverseOffset;
+    char padding[24];
+};
+static_assert(sizeof(FileHeader) == 128, "Unexpected snapshot header size");
+
+std::size_t align(std::size_t offset)
+{
+    return (offset + SNAPSHOT_ALIGNMENT - 1) / SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT;
+}
+
+// Writes bytes and pads the file to the start of the next section.
+void writeSection(std::ofstream &out, std::size_t &position, const void *data, std::size_t bytes)
+{
+    static const char zeros[SNAPSHOT_ALIGNMENT] = {};
+    out.write (static_cast<const char *>(data), bytes);
+    position += bytes;
+    out.write (zeros, align (position) - position);
+    position = align (position);
+    if(!out)
+        throw HilbertIOError();
+}
+
+FileHeader readHeader(const char *data, std::size_t size)
+{
+    FileHeader header;
+    if(size < sizeof(header))
+        throw HilbertIOError();
+    std::memcpy(&header, data, sizeof(header));
+    if(std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ||
+       header.byteOrder != SNAPSHOT_BYTE_ORDER || header.version == 0 ||
+       header.version > PLOT_SNAPSHOT_VERSION)
+        throw HilbertIOError();
+    uint64_t lenght = uint64_t(header.width) * header.height;
+    if(header.type > HilbertCurve::H39 || header.aggregation > HilbertPlot::Last ||
+       lenght > std::numeric_limits<hint>::max () || header.values > lenght)
+        throw HilbertIOError();
+    return header;
+}
+
+// Checks that a section of count elements of the given size at offset lies
+// inside the file, without overflowing.
+void checkSection(std::size_t size, uint64_t offset, uint64_t count, std::size_t element)
+{
+    if(offset > size || count > (size - offset) / element)
+        throw HilbertIOError();
+}
+}
+
+/*!
+   \class PlotSnapshot
+   \inmodule hilbertlib
+   \ingroup hplot
+   \brief The \c PlotSnapshot class saves a HilbertPlot to a binary file and
+   opens it back.
+
+   A snapshot holds the values of the plot, its range, aggregation mode and
+   curve parameters, so reopening it neither parses text nor computes the
+   range. These optional sections can be added, see Section:
+
+   \table
+   \header \li Section \li Content
+   \row \li \c Curve \li The coordinates of the curve points. Without them
+        the curve is taken from a CurveCache, building it if needed.
+   \row \li \c Difference \li The difference map of the curve, only with
+        \c Curve.
+   \row \li \c InverseMap \li The curve index of each cell. Without it, it's
+        computed from the curve.
+   \endtable
+
+   Every section is written and read in bulk, aligned to 64 bytes. When the
+   file is mapped, the values are used in place, so the plot only reads the
+   pages it touches; the curve and inverse map are copied to memory in
+   parallel. Snapshots are written in the byte order of the machine and
+   can't be opened in the other one.
+
+   \note HilbertIOError exception is thrown if the file can't be written or
+   isn't a valid snapshot.
+*/
+
+/*!
+  Saves \a plot to \a path, with the optional \a sections given.
+ */
+void PlotSnapshot::save(const HilbertPlot &plot, const std::string &path, unsigned sections)
+{
+    if(!(sections & Curve))
+        sections &= ~unsigned(Difference);
+    const HilbertCurve &curve = plot;
+    std::size_t lenght = curve.lenght ();
+
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.version = PLOT_SNAPSHOT_VERSION;
+    header.byteOrder = SNAPSHOT_BYTE_ORDER;
+    header.sections = sections;
+    header.type = curve.type ();
+    header.aggregation = plot.aggregation ();
+    header.width = curve.width ();
+    header.height = curve.height ();
+    header.values = plot.m_data.size ();
+    header.min = plot.min ();
+    header.max = plot.max ();
+    header.meanDifference = curve.m_mean_difference;
+
+    std::size_t offset = align (sizeof(header));
+    header.dataOffset = offset;
+    offset = align (offset + header.values * sizeof(hfloat));
+    if(sections & Curve)
+    {
+        header.curveOffset = offset;
+        offset = align (offset + lenght * 2 * sizeof(uint32_t));
+    }
+    if(sections & Difference)
+    {
+        header.differenceOffset = offset;
+        offset = align (offset + lenght * sizeof(double));
+    }
+    if(sections & InverseMap)
+        header.inverseOffset = offset;
+
+    std::ofstream out(path.c_str (), std::ios::binary);
+    if(!out)
+        throw HilbertIOError();
+    std::size_t position = 0;
+    writeSection (out, position, &header, sizeof(header));
+    writeSection (out, position, plot.m_data.data (), header.values * sizeof(hfloat));
+
+    const std::vector<HPoint> &points = curve.m_curve;
+    if(sections & Curve)
+    {
+        std::vector<uint32_t> block;
+        block.reserve (2 * SNAPSHOT_BLOCK_SIZE);
+        for(std::size_t first = 0; first < lenght; first += SNAPSHOT_BLOCK_SIZE)
+        {
+            std::size_t last = std::min(lenght, first + SNAPSHOT_BLOCK_SIZE);
+            block.clear ();
+            for(std::size_t i = first; i < last; ++i)
+            {
+                block.push_back (points[i].x);
+                block.push_back (points[i].y);
+            }
+            out.write (reinterpret_cast<const char *>(block.data ()), block.size () * sizeof(uint32_t));
+            position += block.size () * sizeof(uint32_t);
+        }
+        writeSection (out, position, nullptr, 0);
+    }
+    if(sections & Difference)
+    {
+        std::vector<double> block;
+        block.reserve (SNAPSHOT_BLOCK_SIZE);
+        for(std::size_t first = 0; first < lenght; first += SNAPSHOT_BLOCK_SIZE)
+        {
+            std::size_t last = std::min(lenght, first + SNAPSHOT_BLOCK_SIZE);
+            block.clear ();
+            for(std::size_t i = first; i < last; ++i)
+                block.push_back (points[i].difference);
+            out.write (reinterpret_cast<const char *>(block.data ()), block.size () * sizeof(double));
+            position += block.size () * sizeof(double);
+        }
+        writeSection (out, position, nullptr, 0);
+    }
+    if(sections & InverseMap)
+    {
+        static_assert(sizeof(hint) == sizeof(uint32_t), "The inverse map is stored as 32 bits indices");
+        for(const std::vector<hint> &column : plot.m_plotToCurve)
+        {
+            out.write (reinterpret_cast<const char *>(column.data ()), column.size () * sizeof(hint));
+            position += column.size () * sizeof(hint);
+        }
+        writeSection (out, position, nullptr, 0);
+    }
+    out.close ();
+    if(!out)
+        throw HilbertIOError();
+}
+/*!
+  Opens the snapshot at \a path. If \a mapped is \c true the values are read
+  from the mapped file as needed, otherwise they are copied to memory. The
+  curve is taken from \a cache if it wasn't saved.
+ */
+HilbertPlot PlotSnapshot::load(const std::string &path, bool mapped, CurveCache &cache)
+{
+    std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>(path);
+    FileHeader header = readHeader (file->data (), file->size ());
+    std::size_t lenght = std::size_t(header.width) * header.height;
+    checkSection (file->size (), header.dataOffset, header.values, sizeof(hfloat));
+    if(header.sections & Curve)
+        checkSection (file->size (), header.curveOffset, lenght, 2 * sizeof(uint32_t));
+    if(header.sections & Difference)
+        checkSection (file->size (), header.differenceOffset, lenght, sizeof(double));
+    if(header.sections & InverseMap)
+        checkSection (file->size (), header.inverseOffset, lenght, sizeof(hint));
+
+    // Curve points and inverse map indices read from the file are checked
+    // before being used as indices.
+    std::atomic<bool> valid(true);
+
+    HilbertPlot plot;
+    HilbertCurve &curve = plot;
+    if(header.sections & Curve)
+    {
+        curve.n = header.height;
+        curve.m = header.width;
+        curve.m_type = HilbertCurve::CurveType(header.type);
+        curve.m_mean_difference = header.meanDifference;
+        std::vector<HPoint> &points = curve.m_curve;
+        try
+        {
+            points.clear ();
+            points.reserve (lenght);
+            HugePages::advise (points.data (), lenght * sizeof(HPoint));
+            points.resize (lenght);
+        }
+        catch (std::bad_alloc& ba)
+        {
+            throw HilbertBadAlloc();
+        }
+        const uint32_t *coordinates = reinterpret_cast<const uint32_t *>(file->data () + header.curveOffset);
+        const double *difference = header.sections & Difference ?
+                    reinterpret_cast<const double *>(file->data () + header.differenceOffset) : nullptr;
+        file->advise (header.curveOffset, lenght * 2 * sizeof(uint32_t), MappedFile::Sequential);
+        for_each_chunk_parallel (lenght, parallel_chunk_count (lenght, SNAPSHOT_BLOCK_SIZE),
+                                 [&](unsigned long, unsigned long begin, unsigned long end)
+        {
+            for(std::size_t i = begin; i < end; ++i)
+            {
+                HPoint &point = points[i];
+                point.x = coordinates[2 * i];
+                point.y = coordinates[2 * i + 1];
+                point.difference = difference ? difference[i] : 0.0;
+                point.index = hint(i);
+                if(point.x >= header.width || point.y >= header.height)
+                    valid = false;
+            }
+        });
+        if(!valid)
+            throw HilbertIOError();
+    }
+    else
+    {
+        CurveCache::CurvePointer cached = cache.curve (header.width, header.height, HilbertCurve::CurveType(header.type));
+        curve.n = cached->n;
+        curve.m = cached->m;
+        curve.m_type = cached->m_type;
+        curve.m_mean_difference = cached->m_mean_difference;
+        curve.m_curve = cached->m_curve;
+    }
+    if(curve.lenght () != lenght)
+        throw HilbertIOError();
+
+    try
+    {
+        plot.m_plotToCurve.assign (header.width, std::vector<hint>(header.height));
+    }
+    catch (std::bad_alloc& ba)
+    {
+        throw HilbertBadAlloc();
+    }
+    if(header.sections & InverseMap)
+    {
+        const hint *inverse = reinterpret_cast<const hint *>(file->data () + header.inverseOffset);
+        for_each_chunk_parallel (header.width, parallel_chunk_count (header.width, 64),
+                                 [&](unsigned long, unsigned long begin, unsigned long end)
+        {
+            for(std::size_t x = begin; x < end; ++x)
+            {
+                std::vector<hint> &column = plot.m_plotToCurve[x];
+                std::memcpy(column.data (), inverse + x * header.height, header.height * sizeof(hint));
+                if(std::any_of(column.begin (), column.end (), [&](hint index) {return index >= lenght;}))
+                    valid = false;
+            }
+        });
+        if(!valid)
+            throw HilbertIOError();
+    }
+    else
+    {
+        const std::vector<HPoint> &points = curve.m_curve;
+        for_each_chunk_parallel (lenght, parallel_chunk_count (lenght, SNAPSHOT_BLOCK_SIZE),
+                                 [&](unsigned long, unsigned long begin, unsigned long end)
+        {
+            for(std::size_t i = begin; i < end; ++i)
+                plot.m_plotToCurve[points[i].x][points[i].y] = points[i].index;
+        });
+    }
+
+    const hfloat *values = reinterpret_cast<const hfloat *>(file->data () + header.dataOffset);
+    if(mapped)
+    {
+        plot.m_storage.reset ();
+        plot.m_data = DataView(values, header.values, file);
+    }
+    else
+    {
+        plot.m_storage = std::make_shared<DataSequence>(std::vector<hfloat>(values, values + header.values));
+        plot.m_data = DataView(plot.m_storage->data (), plot.m_storage->size ());
+    }
+    plot.m_min = header.min;
+    plot.m_max = header.max;
+    plot.m_aggregation = HilbertPlot::AggregationMode(header.aggregation);
+    return plot;
+}
+/*!
+  Returns the description of the snapshot at \a path, reading only its
+  header.
+ */
+PlotSnapshot::Info PlotSnapshot::info(const std::string &path)
+{
+    MappedFile file(path, 0, sizeof(FileHeader));
+    FileHeader header = readHeader (file.data (), file.size ());
+    Info info;
+    info.version = header.version;
+    info.sections = header.sections;
+    info.width = header.width;
+    info.height = header.height;
+    info.type = HilbertCurve::CurveType(header.type);
+    info.aggregation = HilbertPlot::AggregationMode(header.aggregation);
+    info.values = header.values;
+    info.min = header.min;
+    info.max = header.max;
+    info.meanDifference = header.meanDifference;
+    return info;
+}
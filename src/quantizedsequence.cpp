@@ -0,0 +1,600 @@
+/*!
+   \headerfile "quantizedsequence.h"
+
+   \title Quantized Sequence Declaration
+
+   \brief The "quantizedsequence.h" header define QuantizedSequence class
+ */
+#include "quantizedsequence.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+#include "parallel_algorithm.h"
+
+namespace
+{
+const unsigned long QUANTIZED_CHUNK_SIZE = 1 << 16;
+
+struct Half
+{
+    uint16_t bits;
+};
+
+inline float widen(uint8_t sample) {return sample;}
+inline float widen(int16_t sample) {return sample;}
+inline float widen(Half sample) {return QuantizedSequence::halfToFloat (sample.bits);}
+inline float widen(float sample) {return sample;}
+
+// Each kernel is called with the samples in their stored type, so the loops
+// widen them one by one instead of reading a converted copy.
+struct RangeKernel
+{
+    float min;
+    float max;
+
+    template <typename T>
+    void operator()(const T *samples, std::size_t size)
+    {
+        unsigned long chunks = parallel_chunk_count (size, QUANTIZED_CHUNK_SIZE);
+        std::vector<float> mins(chunks, std::numeric_limits<float>::infinity());
+        std::vector<float> maxs(chunks, -std::numeric_limits<float>::infinity());
+        for_each_chunk_parallel (size, chunks, [&](unsigned long chunk, unsigned long begin, unsigned long end)
+        {
+            float low = mins[chunk], high = maxs[chunk];
+            for(std::size_t i = begin; i < end; ++i)
+            {
+                float value = widen (samples[i]);
+                low = std::min(low, value);
+                high = std::max(high, value);
+            }
+            mins[chunk] = low;
+            maxs[chunk] = high;
+        });
+        min = *std::min_element(mins.begin (), mins.end ());
+        max = *std::max_element(maxs.begin (), maxs.end ());
+    }
+};
+
+struct SumKernel
+{
+    hfloat center;
+    bool squares;
+    hfloat sum;
+
+    template <typename T>
+    void operator()(const T *samples, std::size_t size)
+    {
+        unsigned long chunks = parallel_chunk_count (size, QUANTIZED_CHUNK_SIZE);
+        std::vector<hfloat> sums(chunks, 0.0);
+        for_each_chunk_parallel (size, chunks, [&](unsigned long chunk, unsigned long begin, unsigned long end)
+        {
+            hfloat partial = 0.0;
+            for(std::size_t i = begin; i < end; ++i)
+            {
+                hfloat value = widen (samples[i]) - center;
+                partial += squares ? value * value : value;
+            }
+            sums[chunk] = partial;
+        });
+        sum = 0.0;
+        for(hfloat partial : sums)
+            sum += partial;
+    }
+};
+
+struct DecodeKernel
+{
+    std::size_t first;
+    std::size_t count;
+    hfloat *output;
+    hfloat scale;
+    hfloat offset;
+
+    template <typename T>
+    void operator()(const T *samples, std::size_t)
+    {
+        samples += first;
+        for(std::size_t i = 0; i < count; ++i)
+            output[i] = widen (samples[i]) * scale + offset;
+    }
+};
+
+struct AggregateKernel
+{
+    HilbertPlot::AggregationMode aggregation;
+    hfloat scale;
+    hfloat offset;
+    DataSequence *output;
+
+    template <typename T>
+    void operator()(const T *samples, std::size_t size)
+    {
+        std::size_t cells = output->size ();
+        for_each_chunk_parallel (cells, parallel_chunk_count (cells, 256),
+                                 [&](unsigned long, unsigned long begin, unsigned long end)
+        {
+            for(std::size_t cell = begin; cell < end; ++cell)
+            {
+                std::pair<std::size_t, std::size_t> block = HilbertPlot::aggregateBlock (size, cells, cell);
+                HilbertPlot::BlockAccumulator accumulator;
+                for(std::size_t i = block.first; i < block.second; ++i)
+                    accumulator.add (widen (samples[i]) * scale + offset);
+                (*output)[cell] = accumulator.value (aggregation);
+            }
+        });
+    }
+};
+
+struct ImageKernel
+{
+    const HilbertCurve *curve;
+    HImage *image;
+    hfloat scale;
+    hfloat offset;
+
+    template <typename T>
+    void operator()(const T *samples, std::size_t size)
+    {
+        std::size_t lenght = std::min<std::size_t>(size, curve->lenght ());
+        for_each_chunk_parallel (lenght, parallel_chunk_count (lenght, QUANTIZED_CHUNK_SIZE),
+                                 [&](unsigned long, unsigned long begin, unsigned long end)
+        {
+            for(std::size_t i = begin; i < end; ++i)
+            {
+                const HPoint &point = (*curve)[i];
+                (*image)[point.X ()][point.Y ()] = widen (samples[i]) * scale + offset;
+            }
+        });
+    }
+};
+}
+
+// Calls kernel with the samples in their stored type.
+template <typename Kernel>
+void QuantizedSequence::apply(Kernel &kernel) const
+{
+    const uint8_t *samples = m_samples.data ();
+    switch (m_format)
+    {
+        case UInt8:
+            kernel(samples, m_size);
+            break;
+        case Int16:
+            kernel(reinterpret_cast<const int16_t *>(samples), m_size);
+            break;
+        case Float16:
+            kernel(reinterpret_cast<const Half *>(samples), m_size);
+            break;
+        case Float32:
+            kernel(reinterpret_cast<const float *>(samples), m_size);
+            break;
+    }
+}
+
+/*!
+   \class QuantizedSequence
+   \inmodule hilbertlib
+   \ingroup hdata
+   \brief The \c QuantizedSequence class stores a sequence of values in 8,
+   16 or 32 bits samples.
+
+   Data coming from 8 or 16 bits sensors takes 4 to 8 times less memory
+   stored in its own format than as hfloat. Each sample represents the value
+   \c{sample * scale() + offset()}, with samples of the given Format:
+
+   \table
+   \header \li Format \li Sample
+   \row \li \c UInt8 \li Unsigned 8 bits integer.
+   \row \li \c Int16 \li Signed 16 bits integer.
+   \row \li \c Float16 \li IEEE 754 half precision float.
+   \row \li \c Float32 \li IEEE 754 single precision float.
+   \endtable
+
+   The statistics, aggregate() and image() read the samples in their own
+   type, converting each one as it's used, so they pass over a fraction of
+   the memory a DataSequence would need. decode() and toSequence() give the
+   values as hfloat for the functions needing them.
+
+   quantize() stores a DataView in the format given, choosing the scale and
+   offset that cover its range.
+
+   The samples always come from MemoryResource::defaultResource(), so a
+   sequence built inside a MemoryResource::Scope outlives its arena.
+*/
+
+/*!
+  Constructs an empty sequence of \c Float32 samples.
+ */
+QuantizedSequence::QuantizedSequence():
+    m_format(Float32),
+    m_size(0),
+    m_scale(1.0),
+    m_offset(0.0),
+    m_samples(ResourceAllocator<uint8_t>(MemoryResource::defaultResource ()))
+{}
+/*!
+  Constructs a sequence of \a size zero samples of \a format, representing
+  the values \c{sample * scale + offset}.
+ */
+QuantizedSequence::QuantizedSequence(Format format, std::size_t size, hfloat scale, hfloat offset):
+    m_format(format),
+    m_size(size),
+    m_scale(scale),
+    m_offset(offset),
+    m_samples(ResourceAllocator<uint8_t>(MemoryResource::defaultResource ()))
+{
+    try
+    {
+        m_samples.assign (size * sampleSize (format), 0);
+    }
+    catch (std::bad_alloc& ba)
+    {
+        throw HilbertBadAlloc();
+    }
+}
+/*!
+  Returns the values of \a data stored in \a format. Integer formats map the
+  range of \a data to the whole range of the samples; float formats keep the
+  values with unit scale and zero offset.
+ */
+QuantizedSequence QuantizedSequence::quantize(const DataView &data, Format format)
+{
+    hfloat scale = 1.0;
+    hfloat offset = 0.0;
+    if((format == UInt8 || format == Int16) && !data.empty ())
+    {
+        auto range = std::minmax_element(data.begin (), data.end ());
+        hfloat width = *range.second - *range.first;
+        hfloat steps = format == UInt8 ? 255.0 : 65535.0;
+        scale = width > 0 ? width / steps : 1.0;
+        offset = format == UInt8 ? *range.first : *range.first + 32768.0 * scale;
+    }
+    QuantizedSequence sequence(format, data.size (), scale, offset);
+    for_each_chunk_parallel (data.size (), parallel_chunk_count (data.size (), QUANTIZED_CHUNK_SIZE),
+                             [&](unsigned long, unsigned long begin, unsigned long end)
+    {
+        for(std::size_t i = begin; i < end; ++i)
+            sequence.set (i, data[i]);
+    });
+    return sequence;
+}
+/*!
+  Returns a sequence with a copy of the \a size samples of \a format at
+  \a samples, representing the values \c{sample * scale + offset}.
+ */
+QuantizedSequence QuantizedSequence::fromRaw(const void *samples, std::size_t size, Format format,
+                                             hfloat scale, hfloat offset)
+{
+    QuantizedSequence sequence(format, size, scale, offset);
+    if(size > 0)
+        std::memcpy(sequence.samples (), samples, sequence.bytes ());
+    return sequence;
+}
+/*!
+  Returns the format of the samples.
+ */
+QuantizedSequence::Format QuantizedSequence::format() const
+{
+    return m_format;
+}
+/*!
+  Returns the number of values.
+ */
+std::size_t QuantizedSequence::size() const
+{
+    return m_size;
+}
+/*!
+  Returns \c true if the sequence has no values.
+ */
+bool QuantizedSequence::empty() const
+{
+    return m_size == 0;
+}
+/*!
+  Returns the bytes of each sample.
+ */
+std::size_t QuantizedSequence::sampleSize() const
+{
+    return sampleSize (m_format);
+}
+/*!
+  Returns the bytes taken by the samples.
+ */
+std::size_t QuantizedSequence::bytes() const
+{
+    return m_size * sampleSize ();
+}
+/*!
+  Returns the factor applied to the samples.
+ */
+hfloat QuantizedSequence::scale() const
+{
+    return m_scale;
+}
+/*!
+  Returns the value added to the scaled samples.
+ */
+hfloat QuantizedSequence::offset() const
+{
+    return m_offset;
+}
+/*!
+  Returns a pointer to the samples.
+ */
+const void *QuantizedSequence::samples() const
+{
+    return m_samples.data ();
+}
+/*!
+  \overload samples()
+ */
+void *QuantizedSequence::samples()
+{
+    return m_samples.data ();
+}
+/*!
+  Returns the value at \a index without checking it.
+ */
+hfloat QuantizedSequence::operator[](std::size_t index) const
+{
+    const uint8_t *sample = m_samples.data () + index * sampleSize ();
+    float value = 0;
+    switch (m_format)
+    {
+        case UInt8:
+            value = *sample;
+            break;
+        case Int16:
+        {
+            int16_t bits;
+            std::memcpy(&bits, sample, sizeof(bits));
+            value = bits;
+            break;
+        }
+        case Float16:
+        {
+            uint16_t bits;
+            std::memcpy(&bits, sample, sizeof(bits));
+            value = halfToFloat (bits);
+            break;
+        }
+        case Float32:
+            std::memcpy(&value, sample, sizeof(value));
+            break;
+    }
+    return value * m_scale + m_offset;
+}
+/*!
+  Returns the value at \a index.
+  \note HilbertIndexOutOfRange() exception is thrown if the given index isn't valid.
+ */
+hfloat QuantizedSequence::at(std::size_t index) const
+{
+    if(index >= m_size)
+        throw HilbertIndexOutOfRange();
+    return (*this)[index];
+}
+/*!
+  Stores \a value at \a index, rounded to the nearest sample. Values out of
+  the range of integer formats are clamped.
+  \note HilbertIndexOutOfRange() exception is thrown if the given index isn't valid.
+ */
+void QuantizedSequence::set(std::size_t index, hfloat value)
+{
+    if(index >= m_size)
+        throw HilbertIndexOutOfRange();
+    uint8_t *sample = m_samples.data () + index * sampleSize ();
+    hfloat scaled = (value - m_offset) / m_scale;
+    switch (m_format)
+    {
+        case UInt8:
+            *sample = uint8_t(std::max(0.0, std::min(255.0, std::round(scaled))));
+            break;
+        case Int16:
+        {
+            int16_t bits = int16_t(std::max(-32768.0, std::min(32767.0, std::round(scaled))));
+            std::memcpy(sample, &bits, sizeof(bits));
+            break;
+        }
+        case Float16:
+        {
+            uint16_t bits = floatToHalf (float(scaled));
+            std::memcpy(sample, &bits, sizeof(bits));
+            break;
+        }
+        case Float32:
+        {
+            float bits = float(scaled);
+            std::memcpy(sample, &bits, sizeof(bits));
+            break;
+        }
+    }
+}
+/*!
+  Writes the \a count values from \a first into \a output.
+  \note HilbertIndexOutOfRange() exception is thrown if the values aren't in the sequence.
+ */
+void QuantizedSequence::decode(std::size_t first, std::size_t count, hfloat *output) const
+{
+    if(first > m_size || count > m_size - first)
+        throw HilbertIndexOutOfRange();
+    DecodeKernel kernel{first, count, output, m_scale, m_offset};
+    apply (kernel);
+}
+/*!
+  Returns the values as a DataSequence.
+ */
+DataSequence QuantizedSequence::toSequence() const
+{
+    DataSequence sequence;
+    try
+    {
+        sequence.resize (m_size);
+    }
+    catch (std::bad_alloc& ba)
+    {
+        throw HilbertBadAlloc();
+    }
+    for_each_chunk_parallel (m_size, parallel_chunk_count (m_size, QUANTIZED_CHUNK_SIZE),
+                             [&](unsigned long, unsigned long begin, unsigned long end)
+    {
+        decode (begin, end - begin, sequence.data () + begin);
+    });
+    return sequence;
+}
+/*!
+  Returns the maximum value, or zero if the sequence is empty.
+ */
+hfloat QuantizedSequence::max() const
+{
+    return range ().second;
+}
+/*!
+  Returns the minimum value, or zero if the sequence is empty.
+ */
+hfloat QuantizedSequence::min() const
+{
+    return range ().first;
+}
+/*!
+  Returns the minimum and maximum values, found in a single pass over the
+  samples.
+ */
+std::pair<hfloat, hfloat> QuantizedSequence::range() const
+{
+    if(empty ())
+        return std::make_pair(0.0, 0.0);
+    RangeKernel kernel{0.0f, 0.0f};
+    apply (kernel);
+    hfloat low = kernel.min * m_scale + m_offset;
+    hfloat high = kernel.max * m_scale + m_offset;
+    return std::make_pair(std::min(low, high), std::max(low, high));
+}
+/*!
+  Returns the mean value.
+ */
+hfloat QuantizedSequence::mean() const
+{
+    if(empty ())
+        return 0;
+    SumKernel kernel{0.0, false, 0.0};
+    apply (kernel);
+    return kernel.sum / hfloat(m_size) * m_scale + m_offset;
+}
+/*!
+  Returns the sample standard deviation of the values.
+ */
+hfloat QuantizedSequence::stdDeviation() const
+{
+    if(m_size < 2)
+        return 0;
+    SumKernel kernel{0.0, false, 0.0};
+    apply (kernel);
+    kernel.center = kernel.sum / hfloat(m_size);
+    kernel.squares = true;
+    apply (kernel);
+    return std::sqrt(kernel.sum / hfloat(m_size - 1)) * std::fabs(m_scale);
+}
+/*!
+  Returns the values reduced to \a cells values by \a aggregation, as
+  HilbertPlot::aggregate() does, reading the samples directly. The result
+  can be given to a HilbertPlot.
+ */
+DataSequence QuantizedSequence::aggregate(std::size_t cells, HilbertPlot::AggregationMode aggregation) const
+{
+    bool truncate = aggregation == HilbertPlot::Truncate || m_size <= cells;
+    DataSequence output;
+    try
+    {
+        output.resize (truncate ? std::min(cells, m_size) : cells);
+    }
+    catch (std::bad_alloc& ba)
+    {
+        throw HilbertBadAlloc();
+    }
+    if(truncate)
+        decode (0, output.size (), output.data ());
+    else if(cells > 0)
+    {
+        AggregateKernel kernel{aggregation, m_scale, m_offset, &output};
+        apply (kernel);
+    }
+    return output;
+}
+/*!
+  Returns the image of the values laid along \a curve, without normalizing
+  them. Points of the curve past the end of the sequence are left at zero.
+ */
+HImage QuantizedSequence::image(const HilbertCurve &curve) const
+{
+    HImage image(curve.width (), std::vector<hfloat>(curve.height (), 0.0));
+    ImageKernel kernel{&curve, &image, m_scale, m_offset};
+    apply (kernel);
+    return image;
+}
+/*!
+  Returns the float represented by the half precision \a half.
+ */
+float QuantizedSequence::halfToFloat(uint16_t half)
+{
+    uint32_t sign = uint32_t(half & 0x8000) << 16;
+    uint32_t exponent = (half >> 10) & 0x1f;
+    uint32_t mantissa = half & 0x3ff;
+    uint32_t bits;
+    if(exponent == 0x1f)
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    else if(exponent != 0)
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    else
+    {
+        // Zero or subnormal, mantissa * 2^-24.
+        float value = std::ldexp(float(mantissa), -24);
+        return sign ? -value : value;
+    }
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+/*!
+  Returns the half precision float nearest to \a value, rounding ties to
+  even. Values too large become infinities.
+ */
+uint16_t QuantizedSequence::floatToHalf(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint16_t sign = uint16_t((bits >> 16) & 0x8000);
+    uint32_t magnitude = bits & 0x7fffffff;
+    if(magnitude > 0x7f800000)
+        return sign | 0x7e00;
+    if(magnitude >= 0x477ff000)
+        return sign | 0x7c00;
+    if(magnitude < 0x38800000)
+    {
+        // Below the smallest normal half, rounded to a multiple of 2^-24.
+        float absolute;
+        std::memcpy(&absolute, &magnitude, sizeof(absolute));
+        return sign | uint16_t(std::nearbyint(absolute * 16777216.0f));
+    }
+    uint32_t rounded = magnitude + 0xfff + ((magnitude >> 13) & 1);
+    return sign | uint16_t((rounded - 0x38000000) >> 13);
+}
+/*!
+  Returns the bytes of each sample of \a format.
+ */
+std::size_t QuantizedSequence::sampleSize(Format format)
+{
+    switch (format)
+    {
+        case UInt8:
+            return 1;
+        case Int16:
+        case Float16:
+            return 2;
+        default:
+            return 4;
+    }
+}
@@ -0,0 +1,585 @@
+/*!
+   \headerfile "rasterexporter.h"
+
+   \title Raster Exporter Declaration
+
+   \brief The "rasterexporter.h" header define RasterExporter class
+ */
+#include "rasterexporter.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <vector>
+#include "parallel_algorithm.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define HILBERT_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+const char NPY_MAGIC[] = "\x93NUMPY";
+const std::size_t NPY_MAGIC_SIZE = 6;
+const std::size_t NPY_ALIGNMENT = 64;
+// Values per parallel chunk when encoding lines.
+const std::size_t RASTER_CHUNK_VALUES = 1 << 16;
+
+// How values are stored: the sample type, whether its bytes are swapped to
+// the file byte order, the channels per value and, for 8 bit samples, the
+// range mapped to [0, 255].
+struct Encoding
+{
+    BinaryLoader::SampleType type;
+    bool swap;
+    std::size_t channels;
+    hfloat minimum;
+    hfloat scale;
+
+    std::size_t bytes() const
+    {
+        return BinaryLoader::sampleSize (type) * channels;
+    }
+    bool identity() const
+    {
+        return type == BinaryLoader::Float64 && !swap && channels == 1;
+    }
+};
+
+Encoding encodingOf(RasterExporter::Format format, const RasterExporter::Options &options)
+{
+    Encoding encoding;
+    encoding.type = options.type;
+    encoding.channels = 1;
+    switch (format)
+    {
+        case RasterExporter::Pgm: encoding.type = BinaryLoader::UInt8; break;
+        case RasterExporter::Ppm: encoding.type = BinaryLoader::UInt8; encoding.channels = 3; break;
+        case RasterExporter::Pfm: encoding.type = BinaryLoader::Float32; break;
+        case RasterExporter::Npy: case RasterExporter::Raw: break;
+    }
+    if(encoding.type != BinaryLoader::UInt8 && encoding.type != BinaryLoader::Float32 &&
+       encoding.type != BinaryLoader::Float64)
+        throw HilbertBadOperation();
+    encoding.swap = encoding.type != BinaryLoader::UInt8 && options.order != BinaryLoader::nativeByteOrder ();
+    encoding.minimum = options.minimum;
+    encoding.scale = options.maximum > options.minimum ? 255.0 / (options.maximum - options.minimum) : 0.0;
+    return encoding;
+}
+
+template <typename T>
+void storeSamples(const hfloat *values, std::size_t count, bool swap, char *output)
+{
+    for(std::size_t i = 0; i < count; ++i)
+    {
+        T sample = static_cast<T>(values[i]);
+        char *bytes = output + i * sizeof(T);
+        std::memcpy(bytes, &sample, sizeof(T));
+        if(swap)
+            std::reverse(bytes, bytes + sizeof(T));
+    }
+}
+
+// Stores count values as encoding says at output.
+void encode(const hfloat *values, std::size_t count, const Encoding &encoding, char *output)
+{
+    if(encoding.identity ())
+        std::memcpy(output, values, count * sizeof(hfloat));
+    else if(encoding.type == BinaryLoader::Float64)
+        storeSamples<double>(values, count, encoding.swap, output);
+    else if(encoding.type == BinaryLoader::Float32)
+        storeSamples<float>(values, count, encoding.swap, output);
+    else
+    {
+        unsigned char *bytes = reinterpret_cast<unsigned char *>(output);
+        for(std::size_t i = 0; i < count; ++i)
+        {
+            // NaN fails the first comparison and goes to 0
+            hfloat level = (values[i] - encoding.minimum) * encoding.scale;
+            unsigned char sample = !(level > 0) ? 0 : level >= 255 ? 255 : static_cast<unsigned char>(level + 0.5);
+            for(std::size_t c = 0; c < encoding.channels; ++c)
+                *bytes++ = sample;
+        }
+    }
+}
+
+std::string npyHeader(const Encoding &encoding, hsize width, hsize height, bool fortranOrder)
+{
+    std::string descr;
+    if(encoding.type == BinaryLoader::UInt8)
+        descr = "|u1";
+    else
+    {
+        bool little = (BinaryLoader::nativeByteOrder () == BinaryLoader::LittleEndian) != encoding.swap;
+        descr = std::string(little ? "<" : ">") + (encoding.type == BinaryLoader::Float32 ? "f4" : "f8");
+    }
+    std::string dictionary = "{'descr': '" + descr + "', 'fortran_order': " + (fortranOrder ? "True" : "False") +
+                             ", 'shape': (" + std::to_string (height) + ", " + std::to_string (width) + "), }";
+    // Magic, version and lenght take 10 bytes, the header ends with a new line
+    std::size_t total = NPY_MAGIC_SIZE + 4 + dictionary.size () + 1;
+    dictionary.append ((NPY_ALIGNMENT - total % NPY_ALIGNMENT) % NPY_ALIGNMENT, ' ');
+    dictionary += '\n';
+
+    std::string header(NPY_MAGIC, NPY_MAGIC_SIZE);
+    header += '\x01';
+    header += '\x00';
+    header += static_cast<char>(dictionary.size () & 0xFF);
+    header += static_cast<char>(dictionary.size () >> 8);
+    return header + dictionary;
+}
+
+std::size_t checkedSize(const HImage &image)
+{
+    std::size_t height = image.empty () ? 0 : image[0].size ();
+    for(const std::vector<hfloat> &column : image)
+    {
+        if(column.size () != height)
+            throw HilbertBadSize();
+    }
+    return height;
+}
+
+// Encodes lines of lenght values, given by source(line, scratch), in strips
+// of about RASTER_BUFFER_SIZE bytes and writes them to out, last line first
+// if reverse is set.
+template <typename Source>
+void writeLines(std::ostream &out, std::size_t lines, std::size_t lenght, const Encoding &encoding, bool reverse,
+                Source source)
+{
+    std::size_t lineBytes = lenght * encoding.bytes ();
+    if(lineBytes == 0 || lines == 0)
+        return;
+    std::size_t stripLines = std::min(lines, std::max<std::size_t>(1, RASTER_BUFFER_SIZE / lineBytes));
+    std::vector<char> buffer;
+    try
+    {
+        buffer.resize (stripLines * lineBytes);
+    }
+    catch (std::bad_alloc& ba)
+    {
+        throw HilbertBadAlloc();
+    }
+
+    for(std::size_t strip = 0; strip < lines; strip += stripLines)
+    {
+        std::size_t count = std::min(stripLines, lines - strip);
+        for_each_chunk_parallel (count, parallel_chunk_count (count, std::max<std::size_t>(1, RASTER_CHUNK_VALUES / lenght)),
+                                 [&](unsigned long, unsigned long begin, unsigned long end)
+        {
+            std::vector<hfloat> scratch;
+            for(unsigned long i = begin; i < end; ++i)
+            {
+                std::size_t line = reverse ? lines - 1 - (strip + i) : strip + i;
+                encode (source (line, scratch), lenght, encoding, buffer.data () + i * lineBytes);
+            }
+        });
+        out.write (buffer.data (), count * lineBytes);
+    }
+}
+}
+
+/*!
+   \class RasterExporter
+   \inmodule hilbertlib
+   \ingroup hdata
+   \brief The \c RasterExporter class saves images in binary raster formats.
+
+   Images are saved as NumPy \c .npy arrays of shape (height, width), raw
+   samples without header, binary PGM and PPM, or PFM. Values are written as
+   the sample type of Options for \c .npy and raw files; PGM and PPM take
+   8 bit samples, gray for PPM, and PFM takes 32 bit floats. 8 bit samples
+   map the range of Options to [0, 255], so HilbertPlot::generateImage()
+   images fit the default range [0, 1].
+
+   Images are either a contiguous row-major buffer of width x height values
+   or an HImage. A buffer stored as \c hfloat in native byte order is written
+   with a single call; otherwise rows are encoded in parallel, in strips of
+   RASTER_BUFFER_SIZE bytes, and each strip is written with a single call.
+   The columns of an HImage are contiguous, so its \c .npy files are saved in
+   Fortran order, which NumPy reads as the same (height, width) array.
+
+   Images larger than memory are written by tiles with TileWriter.
+
+   \note HilbertIOError exception is thrown if the file can't be written,
+   HilbertBadOperation exception if the sample type isn't UInt8, Float32 or
+   Float64.
+*/
+
+/*!
+   \class RasterExporter::Options
+   \brief The \c RasterExporter::Options struct holds how samples are stored.
+
+   \c type is the sample type of \c .npy and raw files. \c order is the byte
+   order of raw, \c .npy and PFM files, the native one by default.
+   \c minimum and \c maximum are the values mapped to 0 and 255 in 8 bit
+   samples; values out of the range are clamped and NaN is 0.
+*/
+
+/*!
+   \class RasterExporter::TileWriter
+   \brief The \c RasterExporter::TileWriter class writes an image to a file
+   by tiles.
+
+   The file is created with its full size and, on POSIX systems, mapped in
+   memory, so each tile is encoded in place and the image is never held in
+   memory as a whole. Tiles of the image may come in any order and from
+   several threads as long as they don't overlap. Where memory mapping isn't
+   available tiles are written to the file row by row, one thread at a time.
+   Parts of the image no tile covers are left as zeros.
+
+   \note HilbertIOError exception is thrown if the file can't be created.
+*/
+
+/*!
+  Constructs the options storing samples as \a type and mapping
+  [\a minimum, \a maximum] to 8 bit samples.
+ */
+RasterExporter::Options::Options(BinaryLoader::SampleType type, hfloat minimum, hfloat maximum):
+    type(type),
+    order(BinaryLoader::nativeByteOrder ()),
+    minimum(minimum),
+    maximum(maximum)
+{}
+/*!
+  Creates the file at \a path for a \a width x \a height image in \a format
+  and writes its header.
+  \note HilbertBadSize exception is thrown if the image is empty.
+ */
+RasterExporter::TileWriter::TileWriter(const std::string &path, hsize width, hsize height, Format format,
+                                       const Options &options):
+    m_width(width),
+    m_height(height),
+    m_format(format),
+    m_options(options),
+    m_dataOffset(0),
+    m_size(0),
+    m_data(nullptr)
+{
+    if(width == 0 || height == 0)
+        throw HilbertBadSize();
+    std::string head = header (format, width, height, options);
+    m_dataOffset = head.size ();
+    m_size = m_dataOffset + static_cast<std::size_t>(width) * height * sampleSize (format, options);
+#ifdef HILBERT_HAS_MMAP
+    int fd = ::open(path.c_str (), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0)
+        throw HilbertIOError();
+    void *address = MAP_FAILED;
+    if(::ftruncate(fd, m_size) == 0)
+        address = ::mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(address == MAP_FAILED)
+        throw HilbertIOError();
+    m_data = static_cast<char *>(address);
+    std::memcpy(m_data, head.data (), head.size ());
+#else
+    m_file.open (path.c_str (), std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+    m_file.write (head.data (), head.size ());
+    m_file.seekp (m_size - 1);
+    m_file.put ('\0');
+    if(!m_file)
+        throw HilbertIOError();
+#endif
+}
+/*!
+  Closes the file.
+ */
+RasterExporter::TileWriter::~TileWriter()
+{
+    try
+    {
+        close ();
+    }
+    catch (HilbertIOError &error)
+    {
+    }
+}
+/*!
+  Writes the \a width x \a height tile of row-major \a values with its top
+  left corner at (\a x, \a y) of the image.
+  \note HilbertIndexOutOfRange exception is thrown if the tile isn't inside
+  the image, HilbertBadOperation exception if the writer is closed.
+ */
+void RasterExporter::TileWriter::writeTile(hsize x, hsize y, hsize width, hsize height, const hfloat *values)
+{
+    if(x > m_width || width > m_width - x || y > m_height || height > m_height - y)
+        throw HilbertIndexOutOfRange();
+    Encoding encoding = encodingOf (m_format, m_options);
+    std::size_t bytes = encoding.bytes ();
+    auto offset = [&](std::size_t row)
+    {
+        std::size_t line = m_format == Pfm ? m_height - 1 - (y + row) : y + row;
+        return m_dataOffset + (line * m_width + x) * bytes;
+    };
+
+    if(m_data)
+    {
+        for_each_chunk_parallel (height, parallel_chunk_count (height, std::max<std::size_t>(1, RASTER_CHUNK_VALUES / std::max(width, 1u))),
+                                 [&](unsigned long, unsigned long begin, unsigned long end)
+        {
+            for(unsigned long row = begin; row < end; ++row)
+                encode (values + row * width, width, encoding, m_data + offset (row));
+        });
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(!m_file.is_open ())
+        throw HilbertBadOperation();
+    std::vector<char> buffer(static_cast<std::size_t>(width) * bytes);
+    for(hsize row = 0; row < height; ++row)
+    {
+        encode (values + static_cast<std::size_t>(row) * width, width, encoding, buffer.data ());
+        m_file.seekp (offset (row));
+        m_file.write (buffer.data (), buffer.size ());
+    }
+    if(!m_file)
+        throw HilbertIOError();
+}
+/*!
+  \overload writeTile()
+
+  Writes \a tile with its top left corner at (\a x, \a y) of the image.
+ */
+void RasterExporter::TileWriter::writeTile(hsize x, hsize y, const HImage &tile)
+{
+    std::size_t height = checkedSize (tile);
+    std::size_t width = tile.size ();
+    std::vector<hfloat> values;
+    try
+    {
+        values.resize (width * height);
+    }
+    catch (std::bad_alloc& ba)
+    {
+        throw HilbertBadAlloc();
+    }
+    for(std::size_t column = 0; column < width; ++column)
+    {
+        for(std::size_t row = 0; row < height; ++row)
+            values[row * width + column] = tile[column][row];
+    }
+    writeTile (x, y, width, height, values.data ());
+}
+/*!
+  Unmaps or closes the file. Tiles can't be written afterwards.
+  \note HilbertIOError exception is thrown if the file couldn't be written.
+ */
+void RasterExporter::TileWriter::close()
+{
+#ifdef HILBERT_HAS_MMAP
+    if(m_data)
+    {
+        ::munmap(m_data, m_size);
+        m_data = nullptr;
+    }
+#endif
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_file.is_open ())
+    {
+        m_file.close ();
+        if(!m_file)
+            throw HilbertIOError();
+    }
+}
+/*!
+  Returns the image width.
+ */
+hsize RasterExporter::TileWriter::width() const
+{
+    return m_width;
+}
+/*!
+  Returns the image height.
+ */
+hsize RasterExporter::TileWriter::height() const
+{
+    return m_height;
+}
+/*!
+  Returns \c true if the file is memory mapped.
+ */
+bool RasterExporter::TileWriter::isMapped() const
+{
+    return m_data != nullptr;
+}
+/*!
+  Writes the \a width x \a height image of row-major \a values to \a out in
+  \a format.
+ */
+void RasterExporter::write(const hfloat *values, hsize width, hsize height, std::ostream &out, Format format,
+                           const Options &options)
+{
+    Encoding encoding = encodingOf (format, options);
+    std::string head = header (format, width, height, options);
+    out.write (head.data (), head.size ());
+    std::size_t lenght = width;
+    if(encoding.identity ())
+        out.write (reinterpret_cast<const char *>(values), lenght * height * sizeof(hfloat));
+    else
+        writeLines (out, height, lenght, encoding, format == Pfm, [values, lenght](std::size_t line, std::vector<hfloat> &)
+        {
+            return values + line * lenght;
+        });
+    if(!out)
+        throw HilbertIOError();
+}
+/*!
+  \overload write()
+
+  Writes \a image to \a out in \a format.
+  \note HilbertBadSize exception is thrown if the columns of \a image
+  differ in size.
+ */
+void RasterExporter::write(const HImage &image, std::ostream &out, Format format, const Options &options)
+{
+    std::size_t height = checkedSize (image);
+    std::size_t width = image.size ();
+    Encoding encoding = encodingOf (format, options);
+    if(format == Npy)
+    {
+        std::string head = npyHeader (encoding, width, height, true);
+        out.write (head.data (), head.size ());
+        if(encoding.identity ())
+        {
+            for(const std::vector<hfloat> &column : image)
+                out.write (reinterpret_cast<const char *>(column.data ()), height * sizeof(hfloat));
+        }
+        else
+            writeLines (out, width, height, encoding, false, [&image](std::size_t line, std::vector<hfloat> &)
+            {
+                return image[line].data ();
+            });
+    }
+    else
+    {
+        std::string head = header (format, width, height, options);
+        out.write (head.data (), head.size ());
+        writeLines (out, height, width, encoding, format == Pfm, [&image, width](std::size_t line, std::vector<hfloat> &scratch)
+        {
+            scratch.resize (width);
+            for(std::size_t x = 0; x < width; ++x)
+                scratch[x] = image[x][line];
+            return static_cast<const hfloat *>(scratch.data ());
+        });
+    }
+    if(!out)
+        throw HilbertIOError();
+}
+/*!
+  Saves the \a width x \a height image of row-major \a values to the file
+  at \a path in \a format.
+ */
+void RasterExporter::save(const hfloat *values, hsize width, hsize height, const std::string &path, Format format,
+                          const Options &options)
+{
+    std::ofstream out(path.c_str (), std::ios::binary);
+    if(!out)
+        throw HilbertIOError();
+    write (values, width, height, out, format, options);
+    out.close ();
+    if(!out)
+        throw HilbertIOError();
+}
+/*!
+  \overload save()
+
+  Saves \a image to the file at \a path in \a format.
+ */
+void RasterExporter::save(const HImage &image, const std::string &path, Format format, const Options &options)
+{
+    std::ofstream out(path.c_str (), std::ios::binary);
+    if(!out)
+        throw HilbertIOError();
+    write (image, out, format, options);
+    out.close ();
+    if(!out)
+        throw HilbertIOError();
+}
+/*!
+  \overload save()
+
+  Saves \a image to the file at \a path in the format of its extension.
+  \sa detect()
+ */
+void RasterExporter::save(const HImage &image, const std::string &path, const Options &options)
+{
+    save (image, path, detect (path), options);
+}
+/*!
+  Saves the \a width x \a height image of row-major ARGB \a pixels, as
+  BytePlot::render() returns, to the file at \a path as a color PPM. The
+  alpha channel is dropped.
+ */
+void RasterExporter::savePixels(const uint32_t *pixels, hsize width, hsize height, const std::string &path)
+{
+    std::ofstream out(path.c_str (), std::ios::binary);
+    if(!out)
+        throw HilbertIOError();
+    std::string head = header (Ppm, width, height);
+    out.write (head.data (), head.size ());
+
+    std::size_t count = static_cast<std::size_t>(width) * height;
+    std::vector<char> buffer(3 * std::min(count, RASTER_BUFFER_SIZE / 3));
+    for(std::size_t first = 0; first < count; first += buffer.size () / 3)
+    {
+        std::size_t last = std::min(count, first + buffer.size () / 3);
+        char *rgb = buffer.data ();
+        for(std::size_t i = first; i < last; ++i)
+        {
+            *rgb++ = static_cast<char>(pixels[i] >> 16);
+            *rgb++ = static_cast<char>(pixels[i] >> 8);
+            *rgb++ = static_cast<char>(pixels[i]);
+        }
+        out.write (buffer.data (), rgb - buffer.data ());
+    }
+    out.close ();
+    if(!out)
+        throw HilbertIOError();
+}
+/*!
+  Returns the header of a \a width x \a height image in \a format, empty
+  for raw files.
+ */
+std::string RasterExporter::header(Format format, hsize width, hsize height, const Options &options)
+{
+    std::string size = std::to_string (width) + " " + std::to_string (height) + "\n";
+    switch (format)
+    {
+        case Npy: return npyHeader (encodingOf (format, options), width, height, false);
+        case Raw: return std::string();
+        case Pgm: return "P5\n" + size + "255\n";
+        case Ppm: return "P6\n" + size + "255\n";
+        case Pfm: return "Pf\n" + size + (options.order == BinaryLoader::LittleEndian ? "-1.0\n" : "1.0\n");
+    }
+    return std::string();
+}
+/*!
+  Returns the size in bytes of a pixel in \a format.
+ */
+std::size_t RasterExporter::sampleSize(Format format, const Options &options)
+{
+    return encodingOf (format, options).bytes ();
+}
+/*!
+  Returns the format of the extension of \a path: \c .npy, \c .raw or
+  \c .bin, \c .pgm, \c .ppm or \c .pfm, in any case.
+  \note HilbertBadOperation exception is thrown for other extensions.
+ */
+RasterExporter::Format RasterExporter::detect(const std::string &path)
+{
+    std::size_t dot = path.find_last_of ('.');
+    if(dot == std::string::npos)
+        throw HilbertBadOperation();
+    std::string extension = path.substr (dot + 1);
+    for(char &character : extension)
+        character = static_cast<char>(std::tolower(static_cast<unsigned char>(character)));
+    if(extension == "npy") return Npy;
+    if(extension == "raw" || extension == "bin") return Raw;
+    if(extension == "pgm") return Pgm;
+    if(extension == "ppm") return Ppm;
+    if(extension == "pfm") return Pfm;
+    throw HilbertBadOperation();
+}
@@ -0,0 +1,338 @@
+/*!
+   \headerfile "recurrenceplot.h"
+
+   \title Recurrence Plot Declaration
+
+   \brief The "recurrenceplot.h" header define RecurrencePlot class
+ */
+#include "recurrenceplot.h"
+#include <algorithm>
+#include <cmath>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "parallel_algorithm.h"
+
+namespace
+{
+// Words of 64 columns computed for each row of a tile
+const hsize TILE_WORDS = 64;
+const hsize WORD_BITS = 64;
+
+inline unsigned countTrailingZeros(uint64_t word)
+{
+#ifdef __GNUC__
+    return __builtin_ctzll(word);
+#else
+    unsigned n = 0;
+    while(!(word & 1)) { word >>= 1; ++n; }
+    return n;
+#endif
+}
+
+inline unsigned popCount(uint64_t word)
+{
+#ifdef __GNUC__
+    return __builtin_popcountll(word);
+#else
+    unsigned n = 0;
+    for(; word; word &= word - 1) ++n;
+    return n;
+#endif
+}
+
+// Bit b of the result is set when |a[b] - x| < epsilon, for b < count.
+inline uint64_t compareWord(const hfloat *a, hfloat x, hfloat epsilon, unsigned count)
+{
+    uint64_t mask = 0;
+    unsigned k = 0;
+#ifdef __SSE2__
+    const __m128d value = _mm_set1_pd(x);
+    const __m128d eps = _mm_set1_pd(epsilon);
+    const __m128d absMask = _mm_castsi128_pd(_mm_set1_epi64x(0x7FFFFFFFFFFFFFFFll));
+    for(; k + 2 <= count; k += 2)
+    {
+        __m128d diff = _mm_and_pd(_mm_sub_pd(_mm_loadu_pd(a + k), value), absMask);
+        mask |= uint64_t(_mm_movemask_pd(_mm_cmplt_pd(diff, eps))) << k;
+    }
+#endif
+    for(; k < count; ++k)
+        mask |= uint64_t(std::fabs(a[k] - x) < epsilon) << k;
+    return mask;
+}
+
+// Bit b of the result is set when |a[b] - b[b]| < epsilon, for b < count.
+inline uint64_t compareWord(const hfloat *a, const hfloat *b, hfloat epsilon, unsigned count)
+{
+    uint64_t mask = 0;
+    unsigned k = 0;
+#ifdef __SSE2__
+    const __m128d eps = _mm_set1_pd(epsilon);
+    const __m128d absMask = _mm_castsi128_pd(_mm_set1_epi64x(0x7FFFFFFFFFFFFFFFll));
+    for(; k + 2 <= count; k += 2)
+    {
+        __m128d diff = _mm_and_pd(_mm_sub_pd(_mm_loadu_pd(a + k), _mm_loadu_pd(b + k)), absMask);
+        mask |= uint64_t(_mm_movemask_pd(_mm_cmplt_pd(diff, eps))) << k;
+    }
+#endif
+    for(; k < count; ++k)
+        mask |= uint64_t(std::fabs(a[k] - b[k]) < epsilon) << k;
+    return mask;
+}
+}
+
+/*!
+   \class RecurrencePlot
+   \inmodule hilbertlib
+   \ingroup hdata
+   \brief The \c RecurrencePlot class holds the recurrence matrix of a DataSequence.
+
+   Two instants \c i and \c j are recurrent when their states are closer than
+   \c epsilon. The states are the data values or, when an embedding
+   \c dimension greater than one is given, the delay vectors
+   \c{(x[i], x[i+delay], ..., x[i+(dimension-1)*delay])} compared with the
+   maximum norm.
+
+   The matrix is stored bit-packed, one bit per pair and 64 columns per word,
+   and it is computed by tiles in parallel. For long sequences where the
+   \c{O(n^2)} matrix doesn't fit in memory, quantify() computes the recurrence
+   quantification without materializing it.
+*/
+
+/*!
+  \brief Default Constructor
+  Constructs an empty recurrence plot.
+*/
+RecurrencePlot::RecurrencePlot():
+    m_size(0), m_words(0), m_epsilon(0), m_dimension(1), m_delay(1)
+{}
+/*!
+  \brief General Constructor
+
+  Constructs the recurrence matrix of \a data for the neighbourhood \a epsilon.
+  States are embedded using \a dimension and \a delay.
+*/
+RecurrencePlot::RecurrencePlot(const DataSequence &data, hfloat epsilon, hsize dimension, hsize delay):
+    m_size(embeddedSize (data.size (), dimension, delay)),
+    m_words((m_size + WORD_BITS - 1) / WORD_BITS),
+    m_epsilon(epsilon),
+    m_dimension(dimension),
+    m_delay(delay)
+{
+    try
+    {
+        m_bits.assign (std::size_t(m_size) * m_words, 0);
+    }
+    catch (std::bad_alloc& ba)
+    {
+        throw HilbertBadAlloc();
+    }
+
+    const hfloat *x = data.data ();
+    const hsize size = m_size;
+    const hsize words = m_words;
+    uint64_t *bits = m_bits.data ();
+    for_each_chunk_parallel (size, parallel_chunk_count (size, 64),
+                             [=](unsigned long, unsigned long rowBegin, unsigned long rowEnd)
+    {
+        // Tiles of rows x TILE_WORDS words keep the compared columns in cache
+        for(hsize tile = 0; tile < words; tile += TILE_WORDS)
+        {
+            hsize tileEnd = std::min(tile + TILE_WORDS, words);
+            for(unsigned long i = rowBegin; i < rowEnd; ++i)
+            {
+                uint64_t *row = bits + i * words;
+                for(hsize w = tile; w < tileEnd; ++w)
+                {
+                    hsize j = w * WORD_BITS;
+                    unsigned count = std::min(WORD_BITS, size - j);
+                    uint64_t mask = compareWord (x + j, x[i], epsilon, count);
+                    for(hsize k = 1; k < dimension && mask; ++k)
+                        mask &= compareWord (x + j + k * delay, x[i + k * delay], epsilon, count);
+                    row[w] = mask;
+                }
+            }
+        }
+    });
+}
+/*!
+  Returns the number of states, that is the matrix is \c{size() x size()}.
+*/
+hsize RecurrencePlot::size() const
+{
+    return m_size;
+}
+/*!
+  Returns the number of 64 bits words used by each row.
+*/
+hsize RecurrencePlot::wordsPerRow() const
+{
+    return m_words;
+}
+/*!
+  Returns the neighbourhood radius.
+*/
+hfloat RecurrencePlot::epsilon() const
+{
+    return m_epsilon;
+}
+/*!
+  Returns the embedding dimension.
+*/
+hsize RecurrencePlot::dimension() const
+{
+    return m_dimension;
+}
+/*!
+  Returns the embedding delay.
+*/
+hsize RecurrencePlot::delay() const
+{
+    return m_delay;
+}
+/*!
+  Returns \c true if states \a i and \a j are recurrent.
+  \note HilbertIndexOutOfRange() exception is thrown if the given indexes aren't valid.
+*/
+bool RecurrencePlot::isRecurrent(hsize i, hsize j) const
+{
+    if(i >= m_size || j >= m_size)
+        throw HilbertIndexOutOfRange();
+    return (m_bits[std::size_t(i) * m_words + j / WORD_BITS] >> (j % WORD_BITS)) & 1;
+}
+/*!
+  Returns the packed row \a i. Column \c j is the bit \c{j % 64} of the word \c{j / 64}.
+*/
+const uint64_t *RecurrencePlot::row(hsize i) const
+{
+    if(i >= m_size)
+        throw HilbertIndexOutOfRange();
+    return m_bits.data () + std::size_t(i) * m_words;
+}
+/*!
+  Returns the whole packed matrix, \c wordsPerRow() words per row.
+*/
+const std::vector<uint64_t> &RecurrencePlot::bits() const
+{
+    return m_bits;
+}
+/*!
+  Returns the number of recurrent pairs on the matrix.
+*/
+unsigned long long RecurrencePlot::recurrences() const
+{
+    unsigned long long total = 0;
+    for(auto word : m_bits)
+        total += popCount (word);
+    return total;
+}
+/*!
+  Returns the matrix as an HImage where recurrent pairs have value 1 and 0 otherwise.
+*/
+HImage RecurrencePlot::generateImage() const
+{
+    HImage image(m_size, std::vector<hfloat>(m_size, 0));
+    for(hsize i = 0; i < m_size; ++i)
+    {
+        const uint64_t *bits = row (i);
+        for(hsize j = 0; j < m_size; ++j)
+            image[j][i] = (bits[j / WORD_BITS] >> (j % WORD_BITS)) & 1;
+    }
+    return image;
+}
+/*!
+  \brief Streamed recurrence quantification analysis.
+
+  Computes the recurrence rate and the determinism of the recurrence matrix of
+  \a data, with neighbourhood \a epsilon and embedding \a dimension and \a delay,
+  without materializing the matrix. Diagonals are scanned in parallel comparing
+  64 pairs at a time, so memory use is independent of the data size.
+
+  Pairs closer to the main diagonal than \a theilerWindow are excluded. The
+  determinism is the fraction of recurrent pairs that belong to diagonal lines
+  of at least \a minLine points.
+*/
+RecurrencePlot::Quantification RecurrencePlot::quantify(const DataSequence &data, hfloat epsilon, hsize dimension,
+                                                        hsize delay, hsize minLine, hsize theilerWindow)
+{
+    hsize size = embeddedSize (data.size (), dimension, delay);
+    Quantification result = {0, 0, 0, 0, 0};
+    if(theilerWindow >= size)
+        return result;
+
+    struct Counts { unsigned long long recurrences, diagonalRecurrences; };
+    const hfloat *x = data.data ();
+    hsize diagonals = size - theilerWindow;
+    unsigned long chunks = parallel_chunk_count (diagonals, 16);
+    std::vector<Counts> partial(chunks, Counts{0, 0});
+
+    for_each_chunk_parallel (chunks, chunks, [&](unsigned long chunk, unsigned long, unsigned long)
+    {
+        // Diagonals are interleaved among chunks for balancing their lenghts
+        Counts &counts = partial[chunk];
+        for(hsize d = theilerWindow + chunk; d < size; d += chunks)
+        {
+            unsigned long long diagonal = 0;
+            unsigned long long run = 0;
+            // The matrix is symmetric, so the diagonals above the main one count twice
+            unsigned weight = d == 0 ? 1 : 2;
+            hsize lenght = size - d;
+            for(hsize i = 0; i < lenght; i += WORD_BITS)
+            {
+                unsigned count = std::min(WORD_BITS, lenght - i);
+                uint64_t mask = compareWord (x + i, x + i + d, epsilon, count);
+                for(hsize k = 1; k < dimension && mask; ++k)
+                    mask &= compareWord (x + i + k * delay, x + i + d + k * delay, epsilon, count);
+                counts.recurrences += weight * popCount (mask);
+
+                unsigned pos = 0;
+                while(pos < count)
+                {
+                    uint64_t rest = mask >> pos;
+                    unsigned span;
+                    if(rest & 1)
+                    {
+                        span = ~rest ? countTrailingZeros (~rest) : WORD_BITS - pos;
+                        span = std::min(span, count - pos);
+                        run += span;
+                    }
+                    else
+                    {
+                        if(run >= minLine)
+                            diagonal += run;
+                        run = 0;
+                        span = rest ? countTrailingZeros (rest) : count - pos;
+                        span = std::min(span, count - pos);
+                    }
+                    pos += span;
+                }
+            }
+            if(run >= minLine)
+                diagonal += run;
+            counts.diagonalRecurrences += weight * diagonal;
+        }
+    });
+
+    for(auto &counts : partial)
+    {
+        result.recurrences += counts.recurrences;
+        result.diagonalRecurrences += counts.diagonalRecurrences;
+    }
+    unsigned long long excluded = theilerWindow == 0 ? 0 :
+            size + 2ull * (theilerWindow - 1) * size - (theilerWindow - 1ull) * theilerWindow;
+    result.points = (unsigned long long)size * size - excluded;
+    result.recurrenceRate = result.points ? hfloat(result.recurrences) / result.points : 0;
+    result.determinism = result.recurrences ? hfloat(result.diagonalRecurrences) / result.recurrences : 0;
+    return result;
+}
+/*!
+  Number of states for a sequence of \a lenght values embedded with \a dimension and \a delay.
+*/
+hsize RecurrencePlot::embeddedSize(hsize lenght, hsize dimension, hsize delay)
+{
+    if(dimension == 0 || delay == 0)
+        throw HilbertBadOperation();
+    hsize span = (dimension - 1) * delay;
+    return lenght > span ? lenght - span : 0;
+}
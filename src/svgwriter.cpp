@@ -0,0 +1,262 @@
+/*!
+   \headerfile "svgwriter.h"
+
+   \title Svg Writer Declaration
+
+   \brief The "svgwriter.h" header define SvgWriter class
+ */
+#include "svgwriter.h"
+#include <algorithm>
+#include <fstream>
+#include <future>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include "parallel_algorithm.h"
+
+namespace
+{
+// Appends value in decimal, without the iostream machinery.
+void appendInteger(std::string &out, long long value)
+{
+    char digits[24];
+    char *last = digits + sizeof(digits);
+    char *first = last;
+    unsigned long long magnitude = value < 0 ? 0ull - (unsigned long long)value : (unsigned long long)value;
+    do
+    {
+        *--first = char('0' + magnitude % 10);
+        magnitude /= 10;
+    }
+    while(magnitude != 0);
+    if(value < 0)
+        *--first = '-';
+    out.append (first, last);
+}
+}
+
+/*!
+   \class SvgWriter
+   \inmodule hilbertlib
+   \ingroup hcurve
+   \brief The \c SvgWriter class exports a HilbertCurve as SVG.
+
+   The curve is written as a single path, drawn with its Y axis reflected as
+   HilbertCurve::SaveSVG() always did, without modifying it. Consecutive
+   steps in the same direction are merged into a single \c h or \c v
+   command, so most of a Hilbert curve takes a few bytes per turn instead
+   of a pair of coordinates per point. Commands are relative unless
+   Options::relative is \c false.
+
+   The path is formatted in chunks of SVG_CHUNK_STEPS steps on
+   Options::threads threads, and written in order through a buffer of
+   SVG_BUFFER_SIZE bytes, so the whole document is never held in memory.
+   Chunks are cut where a run of steps ends, so the output doesn't depend on
+   the number of threads.
+*/
+
+/*!
+   \class SvgWriter::Options
+   \brief The \c SvgWriter::Options struct holds the style and formatting of
+   the path.
+
+   \c color and \c strokeWidth style the path; \c color must be a valid HTML
+   color. \c simplify merges runs of steps, \c relative selects relative
+   commands, both \c true by default. \c threads formats chunks in parallel;
+   zero, the default, uses one thread per core.
+*/
+
+/*!
+  Constructs the options drawing the path with \a color and \a strokeWidth.
+ */
+SvgWriter::Options::Options(const char *color, float strokeWidth):
+    color(color),
+    strokeWidth(strokeWidth),
+    simplify(true),
+    relative(true),
+    threads(0)
+{}
+/*!
+  Writes \a curve to \a out as an SVG document styled by \a options.
+  \note HilbertIOError exception is thrown if the output fails.
+ */
+void SvgWriter::write(const HilbertCurve &curve, std::ostream &out, const Options &options)
+{
+    std::size_t lenght = curve.lenght ();
+    const HPoint *points = curve.m_curve.data ();
+    long long reflection = (long long)curve.height () - 1 + 2 * (long long)curve.coord.Y ();
+
+    hint xmax = 0, ymin = 0;
+    if(lenght > 0)
+    {
+        unsigned long chunks = parallel_chunk_count (lenght, SVG_CHUNK_STEPS);
+        std::vector<hint> xmaxs(chunks, 0), ymins(chunks, points[0].y);
+        for_each_chunk_parallel (lenght, chunks, [&](unsigned long chunk, unsigned long begin, unsigned long end)
+        {
+            for(std::size_t i = begin; i < end; ++i)
+            {
+                xmaxs[chunk] = std::max(xmaxs[chunk], points[i].x);
+                ymins[chunk] = std::min(ymins[chunk], points[i].y);
+            }
+        });
+        xmax = *std::max_element(xmaxs.begin (), xmaxs.end ());
+        ymin = *std::min_element(ymins.begin (), ymins.end ());
+    }
+
+    std::ostringstream header;
+    header << "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\"?>\n";
+    header << "<svg\n";
+    header << "width=\"" << xmax << "\"\n";
+    header << "height=\"" << (lenght > 0 ? reflection - ymin : 0) << "\"\n";
+    header << "id=\"svg2\"\n";
+    header << "version=\"1.1\">\n";
+    header << "<g>\n";
+    header << "<path\n";
+    header << "style=\"fill:none;stroke:" << options.color << ";stroke-width:" << options.strokeWidth
+           << "px;stroke-linecap:butt;stroke-linejoin:miter;stroke-opacity:1\"\n";
+    header << "d=\"";
+
+    std::string buffer = header.str ();
+    buffer.reserve (SVG_BUFFER_SIZE + SVG_BUFFER_SIZE / 4);
+    if(lenght > 0)
+    {
+        buffer += 'M';
+        appendInteger (buffer, points[0].x);
+        buffer += ',';
+        appendInteger (buffer, reflection - points[0].y);
+    }
+
+    std::size_t steps = lenght > 0 ? lenght - 1 : 0;
+    unsigned int threads = options.threads;
+    if(threads == 0)
+        threads = std::max(std::thread::hardware_concurrency (), 1u);
+    std::vector<std::string> formatted(threads);
+    for(std::size_t batch = 0; batch < steps; )
+    {
+        // Chunk limits, moved forward to the start of the next run.
+        std::vector<std::size_t> limits;
+        for(unsigned int t = 0; t <= threads; ++t)
+        {
+            std::size_t limit = std::min(steps, batch + t * SVG_CHUNK_STEPS);
+            if(options.simplify && t > 0)
+            {
+                limit = std::max(limit, limits.back ());
+                while(limit > 0 && limit < steps && continues (stepAt (points, limit - 1), stepAt (points, limit)))
+                    ++limit;
+            }
+            limits.push_back (limit);
+        }
+        std::vector<std::future<void>> futures;
+        auto format = [&](unsigned int t)
+        {
+            formatted[t].clear ();
+            if(limits[t] < limits[t + 1])
+                formatSteps (points, limits[t], limits[t + 1], points[limits[t]].x,
+                             reflection - points[limits[t]].y, options, formatted[t]);
+        };
+        for(unsigned int t = 1; t < threads; ++t)
+            futures.push_back (std::async(std::launch::async, format, t));
+        format (0);
+        for(auto &future : futures)
+            future.get ();
+        for(unsigned int t = 0; t < threads; ++t)
+        {
+            buffer += formatted[t];
+            if(buffer.size () >= SVG_BUFFER_SIZE)
+            {
+                out.write (buffer.data (), buffer.size ());
+                buffer.clear ();
+            }
+        }
+        batch = limits.back ();
+    }
+    buffer += "\"/>\n</g>\n</svg>";
+    out.write (buffer.data (), buffer.size ());
+    if(!out)
+        throw HilbertIOError();
+}
+/*!
+  Saves \a curve to the file at \a path as an SVG document styled by
+  \a options.
+  \note HilbertIOError exception is thrown if the file can't be written.
+ */
+void SvgWriter::save(const HilbertCurve &curve, const std::string &path, const Options &options)
+{
+    std::ofstream out(path.c_str (), std::ios::binary);
+    if(!out)
+        throw HilbertIOError();
+    write (curve, out, options);
+    out.close ();
+    if(!out)
+        throw HilbertIOError();
+}
+/*!
+  Returns the SVG document of \a curve styled by \a options.
+ */
+std::string SvgWriter::toString(const HilbertCurve &curve, const Options &options)
+{
+    std::ostringstream out;
+    write (curve, out, options);
+    return out.str ();
+}
+
+// Step from point i to point i + 1, with the Y axis reflected as the SVG
+// is drawn.
+SvgWriter::Step SvgWriter::stepAt(const HPoint *points, std::size_t i)
+{
+    Step step;
+    step.dx = (long long)points[i + 1].x - points[i].x;
+    step.dy = (long long)points[i].y - points[i + 1].y;
+    return step;
+}
+
+// Returns true if step goes on in the direction of run.
+bool SvgWriter::continues(const Step &run, const Step &step)
+{
+    if(run.dy == 0 && step.dy == 0)
+        return (run.dx > 0) == (step.dx > 0) && run.dx != 0 && step.dx != 0;
+    if(run.dx == 0 && step.dx == 0)
+        return (run.dy > 0) == (step.dy > 0) && run.dy != 0 && step.dy != 0;
+    return false;
+}
+
+// Formats the steps in [begin, end) as path commands, starting at (x, y) in
+// SVG coordinates.
+void SvgWriter::formatSteps(const HPoint *points, std::size_t begin, std::size_t end, long long x, long long y,
+                            const Options &options, std::string &out)
+{
+    for(std::size_t i = begin; i < end; )
+    {
+        Step run = stepAt (points, i++);
+        if(options.simplify && (run.dx == 0) != (run.dy == 0))
+        {
+            for(; i < end; ++i)
+            {
+                Step step = stepAt (points, i);
+                if(!continues (run, step))
+                    break;
+                run.dx += step.dx;
+                run.dy += step.dy;
+            }
+        }
+        x += run.dx;
+        y += run.dy;
+        if(run.dy == 0)
+        {
+            out += options.relative ? 'h' : 'H';
+            appendInteger (out, options.relative ? run.dx : x);
+        }
+        else if(run.dx == 0)
+        {
+            out += options.relative ? 'v' : 'V';
+            appendInteger (out, options.relative ? run.dy : y);
+        }
+        else
+        {
+            out += options.relative ? 'l' : 'L';
+            appendInteger (out, options.relative ? run.dx : x);
+            out += ',';
+            appendInteger (out, options.relative ? run.dy : y);
+        }
+    }
+}
@@ -0,0 +1,523 @@
+/*!
+   \headerfile "textexporter.h"
+
+   \title Text Exporter Declaration
+
+   \brief The "textexporter.h" header define TextExporter class
+ */
+#include "textexporter.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <limits>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+const double POWERS_OF_TEN[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+// Largest double below which every integer is exact.
+const double EXACT_INTEGER_LIMIT = 9007199254740992.0;
+
+// Decimal value digits * 10^(exponent - count + 1), with count digits.
+struct Decimal
+{
+    uint64_t digits;
+    int count;
+    int exponent;
+};
+
+int digitCount(uint64_t value)
+{
+    int count = 1;
+    while(value >= 10)
+    {
+        value /= 10;
+        ++count;
+    }
+    return count;
+}
+
+// Finds the 15 significant digits of value with plain double arithmetic.
+// Powers of ten up to 1e22 and integers below 2^53 are exact, so dividing
+// back is correctly rounded and tells whether the digits read back as value.
+// Returns false if they don't, or if value is out of the range handled.
+bool fastDigits(double value, Decimal &decimal)
+{
+    if(value < EXACT_INTEGER_LIMIT && value == std::floor(value))
+    {
+        decimal.digits = uint64_t(value);
+        decimal.count = digitCount (decimal.digits);
+        decimal.exponent = decimal.count - 1;
+        return true;
+    }
+    int binary;
+    std::frexp(value, &binary);
+    int exponent = int(std::floor((binary - 1) * 0.30102999566398120));
+    for(int attempt = 0; attempt < 3; ++attempt)
+    {
+        int scale = 14 - exponent;
+        if(scale < 0 || scale > 22)
+            return false;
+        double digits = std::nearbyint(value * POWERS_OF_TEN[scale]);
+        if(digits >= 1e15)
+            ++exponent;
+        else if(digits < 1e14)
+            --exponent;
+        else
+        {
+            if(digits / POWERS_OF_TEN[scale] != value)
+                return false;
+            decimal.digits = uint64_t(digits);
+            decimal.count = 15;
+            decimal.exponent = exponent;
+            return true;
+        }
+    }
+    return false;
+}
+
+#ifdef __SIZEOF_INT128__
+typedef unsigned __int128 Wide;
+// 5^27 is the largest power of five that fits in 64 bits.
+const int EXACT_MAX_SCALE = 27;
+const int EXACT_MIN_SCALE = -2;
+
+Wide powerOfFive(int exponent)
+{
+    Wide power = 1;
+    for(int i = 0; i < exponent; ++i)
+        power *= 5;
+    return power;
+}
+
+// Rounds value to count significant digits with integer arithmetic and
+// tells whether they, or the next ones up, read back as value. This is the
+// case when they lie between the midpoints to the neighbour doubles. With
+// value = mantissa * 2^binary, the digits are value * 10^scale =
+// numerator / denominator, which for scale in [-2, 27] and up to 17 digits
+// fit in 128 bits along with the midpoints.
+bool exactDigits(double value, int count, Decimal &decimal)
+{
+    int binary;
+    double fraction = std::frexp(value, &binary);
+    uint64_t mantissa = uint64_t(std::ldexp(fraction, 53));
+    binary -= 53;
+    bool boundary = mantissa == (uint64_t(1) << 52);
+    Wide limit = 1;
+    for(int i = 0; i < count; ++i)
+        limit *= 10;
+
+    int exponent = int(std::floor((binary + 52) * 0.30102999566398120));
+    for(int attempt = 0; attempt < 3; ++attempt)
+    {
+        int scale = count - 1 - exponent;
+        if(scale < EXACT_MIN_SCALE || scale > EXACT_MAX_SCALE)
+            return false;
+        int shift = binary + scale;
+        Wide power = powerOfFive (std::max(scale, 0)) << std::max(shift, 0);
+        Wide numerator = mantissa * power;
+        Wide digits;
+        Wide remainder;
+        Wide denominator;
+        if(scale >= 0)
+        {
+            // The denominator is a power of two.
+            int bits = std::max(-shift, 0);
+            denominator = Wide(1) << bits;
+            digits = numerator >> bits;
+            remainder = numerator - (digits << bits);
+        }
+        else
+        {
+            denominator = powerOfFive (-scale) << std::max(-shift, 0);
+            digits = numerator / denominator;
+            remainder = numerator % denominator;
+        }
+        if(2 * remainder > denominator || (2 * remainder == denominator && (digits & 1)))
+            ++digits;
+        if(digits >= limit)
+        {
+            ++exponent;
+            continue;
+        }
+        if(digits * 10 < limit)
+        {
+            --exponent;
+            continue;
+        }
+
+        // Midpoints and digits times 4 * denominator.
+        Wide lower = (Wide(4) * mantissa - (boundary ? 1 : 2)) * power;
+        Wide upper = (Wide(4) * mantissa + 2) * power;
+        bool even = (mantissa & 1) == 0;
+        for(Wide candidate = digits; candidate <= digits + (boundary ? 1 : 0) && candidate < limit; ++candidate)
+        {
+            Wide scaled = candidate * denominator * 4;
+            if(even ? (lower <= scaled && scaled <= upper) : (lower < scaled && scaled < upper))
+            {
+                decimal.digits = uint64_t(candidate);
+                decimal.count = count;
+                decimal.exponent = exponent;
+                return true;
+            }
+        }
+        return false;
+    }
+    return false;
+}
+#endif
+
+// Rounds value to count significant digits with the C library.
+Decimal printfDigits(double value, int count)
+{
+    char buffer[40];
+    std::snprintf(buffer, sizeof(buffer), "%.*e", count - 1, value);
+    Decimal decimal = {0, 0, 0};
+    const char *character = buffer;
+    for(; *character != 'e'; ++character)
+    {
+        if(*character >= '0' && *character <= '9')
+        {
+            decimal.digits = decimal.digits * 10 + uint64_t(*character - '0');
+            ++decimal.count;
+        }
+    }
+    decimal.exponent = std::atoi(character + 1);
+    return decimal;
+}
+
+bool readsBack(double value, int count)
+{
+    char buffer[40];
+    std::snprintf(buffer, sizeof(buffer), "%.*e", count - 1, value);
+    return std::strtod(buffer, nullptr) == value;
+}
+
+// Writes decimal in fixed notation for exponents in [-4, 16), like Python's
+// repr, and in scientific notation otherwise.
+std::size_t writeDecimal(bool negative, Decimal decimal, char *output)
+{
+    while(decimal.count > 1 && decimal.digits % 10 == 0)
+    {
+        decimal.digits /= 10;
+        --decimal.count;
+    }
+    char digits[20];
+    for(int i = decimal.count - 1; i >= 0; --i)
+    {
+        digits[i] = char('0' + decimal.digits % 10);
+        decimal.digits /= 10;
+    }
+
+    char *position = output;
+    if(negative)
+        *position++ = '-';
+    int exponent = decimal.exponent;
+    if(exponent >= -4 && exponent < 16)
+    {
+        if(exponent < 0)
+        {
+            *position++ = '0';
+            *position++ = '.';
+            for(int i = exponent + 1; i < 0; ++i)
+                *position++ = '0';
+            std::memcpy(position, digits, decimal.count);
+            position += decimal.count;
+        }
+        else if(decimal.count <= exponent + 1)
+        {
+            std::memcpy(position, digits, decimal.count);
+            position += decimal.count;
+            for(int i = decimal.count; i <= exponent; ++i)
+                *position++ = '0';
+        }
+        else
+        {
+            std::memcpy(position, digits, exponent + 1);
+            position += exponent + 1;
+            *position++ = '.';
+            std::memcpy(position, digits + exponent + 1, decimal.count - exponent - 1);
+            position += decimal.count - exponent - 1;
+        }
+    }
+    else
+    {
+        *position++ = digits[0];
+        if(decimal.count > 1)
+        {
+            *position++ = '.';
+            std::memcpy(position, digits + 1, decimal.count - 1);
+            position += decimal.count - 1;
+        }
+        *position++ = 'e';
+        *position++ = exponent < 0 ? '-' : '+';
+        exponent = std::abs(exponent);
+        if(exponent >= 100)
+            *position++ = char('0' + exponent / 100);
+        *position++ = char('0' + exponent / 10 % 10);
+        *position++ = char('0' + exponent % 10);
+    }
+    return position - output;
+}
+
+// Formats count values, given by valueAt(index), in chunks spread among
+// threads and writes them in order.
+template <typename Func>
+void writeValues(std::size_t count, std::ostream &out, const TextExporter::Options &options, Func valueAt)
+{
+    unsigned int threads = options.threads;
+    if(threads == 0)
+        threads = std::max(std::thread::hardware_concurrency (), 1u);
+    // Short outputs don't start threads
+    threads = static_cast<unsigned int>(std::max<std::size_t>(1, std::min<std::size_t>(
+                  threads, (count + TEXT_EXPORT_CHUNK_SIZE - 1) / TEXT_EXPORT_CHUNK_SIZE)));
+    std::size_t valueSize = TEXT_EXPORT_MAX_LENGTH + std::max<std::size_t>(options.separator.size (), 1);
+    std::vector<std::string> formatted(threads);
+    std::string buffer;
+    buffer.reserve (TEXT_EXPORT_BUFFER_SIZE);
+
+    for(std::size_t batch = 0; batch < count; batch += threads * TEXT_EXPORT_CHUNK_SIZE)
+    {
+        auto format = [&](unsigned int t)
+        {
+            std::string &text = formatted[t];
+            std::size_t begin = std::min(count, batch + t * TEXT_EXPORT_CHUNK_SIZE);
+            std::size_t end = std::min(count, begin + TEXT_EXPORT_CHUNK_SIZE);
+            text.resize ((end - begin) * valueSize);
+            char *position = &text[0];
+            for(std::size_t i = begin; i < end; ++i)
+            {
+                if(i > 0 && options.columns > 0 && i % options.columns == 0)
+                    *position++ = '\n';
+                else if(i > 0)
+                {
+                    std::memcpy(position, options.separator.data (), options.separator.size ());
+                    position += options.separator.size ();
+                }
+                position += TextExporter::format (valueAt (i), position, options.precision);
+            }
+            text.resize (position - text.data ());
+        };
+        std::vector<std::future<void>> futures;
+        for(unsigned int t = 1; t < threads; ++t)
+            futures.push_back (std::async(std::launch::async, format, t));
+        format (0);
+        for(auto &future : futures)
+            future.get ();
+
+        for(const std::string &text : formatted)
+        {
+            buffer += text;
+            if(buffer.size () >= TEXT_EXPORT_BUFFER_SIZE)
+            {
+                out.write (buffer.data (), buffer.size ());
+                buffer.clear ();
+            }
+        }
+    }
+    if(count > 0)
+        buffer += '\n';
+    out.write (buffer.data (), buffer.size ());
+    if(!out)
+        throw HilbertIOError();
+}
+}
+
+/*!
+   \class TextExporter
+   \inmodule hilbertlib
+   \ingroup hdata
+   \brief The \c TextExporter class writes values as text that reads back
+   exactly.
+
+   By default every value is written with the fewest significant digits that
+   read back as the same \c hfloat, so \c 0.1 is written as \c 0.1 and not as
+   \c 0.10000000000000001. Values with up to 15 significant digits, the most
+   common ones, are formatted with a few floating point operations, and
+   values from about 1e-12 to 1e17 needing 16 or 17 digits with exact 128 bit
+   integer arithmetic where the compiler provides it. The rest are rounded
+   by the C library. Values are written in fixed notation if their decimal
+   exponent is in [-4, 16) and in scientific notation otherwise; \c nan and
+   \c inf are written as such.
+
+   Values are joined by Options::separator, and lines are broken every
+   Options::columns values. They are formatted in chunks of
+   TEXT_EXPORT_CHUNK_SIZE values on Options::threads threads and written in
+   order through a buffer of TEXT_EXPORT_BUFFER_SIZE bytes, with no more
+   threads than chunks.
+
+   DataSequence::fromPlainText() reads the output back exactly as long as
+   every value is finite. NumberParser takes letters as separators, so it
+   skips \c nan, \c inf and \c -inf and the values after them shift to
+   lower indices. Data with non-finite values should be saved in a binary
+   format, see RasterExporter.
+
+   \note HilbertIOError exception is thrown if the output fails.
+*/
+
+/*!
+   \class TextExporter::Options
+   \brief The \c TextExporter::Options struct holds the layout of the text.
+
+   \c separator goes between values, a new line by default. \c precision is
+   the number of significant digits, or zero for the shortest exact ones.
+   \c columns is the number of values per line, or zero to use only the
+   separator. \c threads formats chunks in parallel; zero, the default, uses
+   one thread per core.
+*/
+
+/*!
+  Constructs the options joining values with \a separator, writing them
+  with \a precision significant digits and \a columns values per line.
+ */
+TextExporter::Options::Options(const std::string &separator, int precision, std::size_t columns):
+    separator(separator),
+    precision(precision),
+    columns(columns),
+    threads(0)
+{}
+/*!
+  Writes \a value to \a output with \a precision significant digits, or with
+  the shortest exact ones if \a precision is zero, and returns the number of
+  characters written. At most TEXT_EXPORT_MAX_LENGTH characters are written,
+  without a terminating null.
+ */
+std::size_t TextExporter::format(hfloat value, char *output, int precision)
+{
+    if(std::isnan(value))
+    {
+        std::memcpy(output, "nan", 3);
+        return 3;
+    }
+    bool negative = std::signbit(value);
+    value = std::fabs(value);
+    if(std::isinf(value))
+    {
+        std::memcpy(output, "-inf" + (negative ? 0 : 1), negative ? 4 : 3);
+        return negative ? 4 : 3;
+    }
+    if(value == 0)
+        return writeDecimal (negative, Decimal{0, 1, 0}, output);
+
+    if(precision > 0)
+        return writeDecimal (negative, printfDigits (value, std::min(precision, 17)), output);
+
+    Decimal decimal;
+    if(fastDigits (value, decimal))
+        return writeDecimal (negative, decimal, output);
+    // Rounding to 15 digits and dropping the trailing zeros gives the
+    // shortest digits whenever they are 15 or fewer, except for subnormal
+    // values which have less precision.
+    bool subnormal = value < std::numeric_limits<hfloat>::min();
+#ifdef __SIZEOF_INT128__
+    // Within this range every count has its scale in the exact range.
+    if(value >= 1e-12 && value < 1e17)
+    {
+        // The fast path already tried 15 digits within its own range.
+        for(int count = value >= 1e-8 && value < 1e15 ? 16 : 15; count <= 17; ++count)
+        {
+            if(exactDigits (value, count, decimal))
+                return writeDecimal (negative, decimal, output);
+        }
+    }
+#endif
+    int low = subnormal ? 1 : 15;
+    int count = 17;
+    while(low < count)
+    {
+        int middle = (low + count) / 2;
+        if(readsBack (value, middle))
+            count = middle;
+        else
+            low = middle + 1;
+    }
+    return writeDecimal (negative, printfDigits (value, count), output);
+}
+/*!
+  Returns \a value with \a precision significant digits, or with the
+  shortest exact ones if \a precision is zero.
+ */
+std::string TextExporter::toString(hfloat value, int precision)
+{
+    char output[TEXT_EXPORT_MAX_LENGTH];
+    return std::string(output, format (value, output, precision));
+}
+/*!
+  Writes the values of \a data to \a out as text laid out by \a options.
+ */
+void TextExporter::write(const DataView &data, std::ostream &out, const Options &options)
+{
+    const hfloat *values = data.data ();
+    writeValues (data.size (), out, options, [values](std::size_t index)
+    {
+        return values[index];
+    });
+}
+/*!
+  \overload write()
+
+  Writes \a image to \a out as text, a line per row, the values of each row
+  joined by the separator of \a options.
+ */
+void TextExporter::write(const HImage &image, std::ostream &out, const Options &options)
+{
+    std::size_t width = image.size ();
+    std::size_t height = width > 0 ? image[0].size () : 0;
+    for(const std::vector<hfloat> &column : image)
+    {
+        if(column.size () != height)
+            throw HilbertBadSize();
+    }
+    Options layout = options;
+    layout.columns = width;
+    writeValues (width * height, out, layout, [&image, width](std::size_t index)
+    {
+        return image[index % width][index / width];
+    });
+}
+/*!
+  Saves the values of \a data to the file at \a path as text laid out by
+  \a options.
+ */
+void TextExporter::save(const DataView &data, const std::string &path, const Options &options)
+{
+    std::ofstream out(path.c_str (), std::ios::binary);
+    if(!out)
+        throw HilbertIOError();
+    write (data, out, options);
+    out.close ();
+    if(!out)
+        throw HilbertIOError();
+}
+/*!
+  \overload save()
+
+  Saves \a image to the file at \a path as text, a line per row.
+ */
+void TextExporter::save(const HImage &image, const std::string &path, const Options &options)
+{
+    std::ofstream out(path.c_str (), std::ios::binary);
+    if(!out)
+        throw HilbertIOError();
+    write (image, out, options);
+    out.close ();
+    if(!out)
+        throw HilbertIOError();
+}
+/*!
+  Returns the values of \a data as text laid out by \a options.
+ */
+std::string TextExporter::toString(const DataView &data, const Options &options)
+{
+    std::ostringstream out;
+    write (data, out, options);
+    return out.str ();
+}
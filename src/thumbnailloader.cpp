@@ -0,0 +1,268 @@
+/*!
+   \headerfile "thumbnailloader.h"
+
+   \title Thumbnail Loader Declaration
+
+   \brief The "thumbnailloader.h" header define ThumbnailLoader class
+ */
+#include "thumbnailloader.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <future>
+#include <thread>
+
+#include "datasequence.h"
+#include "dataview.h"
+#include "threads_utility.h"
+
+namespace
+{
+typedef std::chrono::steady_clock Clock;
+
+double seconds(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now () - start).count ();
+}
+
+struct FileContent
+{
+    std::size_t id;
+    std::vector<char> data;
+};
+
+std::vector<char> readFile(const std::string &path)
+{
+    std::ifstream input(path.c_str (), std::ios::binary | std::ios::ate);
+    if(!input)
+        throw HilbertIOError();
+    std::streamoff size = input.tellg ();
+    if(size < 0)
+        throw HilbertIOError();
+    std::vector<char> data;
+    try
+    {
+        data.resize (static_cast<std::size_t>(size));
+    }
+    catch (std::bad_alloc& ba)
+    {
+        throw HilbertBadAlloc();
+    }
+    input.seekg (0);
+    if(size > 0 && !input.read (data.data (), size))
+        throw HilbertIOError();
+    return data;
+}
+}
+
+/*!
+   \class ThumbnailLoader
+   \inmodule hilbertlib
+   \ingroup hdata
+   \brief The \c ThumbnailLoader class turns many small files into Hilbert
+   plot thumbnails of a fixed size.
+
+   load() reads the files on a few reader threads that hand their contents to
+   worker threads through a bounded queue, so at most \c queueCapacity files
+   wait in memory. The workers parse each file and render it over the same
+   curve, built once per thumbnail size and taken from a CurveCache. Each
+   thumbnail reports the seconds spent reading, parsing and rendering it.
+
+   Files with more values than thumbnail cells are reduced to the mean of
+   consecutive blocks; shorter ones are padded with zeros, as HilbertPlot
+   does.
+*/
+
+/*!
+   \class ThumbnailLoader::Options
+   \inmodule hilbertlib
+   \brief Holds the thumbnail size and curve, how files are decoded, and the
+   number of threads used.
+
+   Files are read as plain text unless \c format is \c Raw, in which case
+   \c sampleType and \c byteOrder describe the samples. A zero \c workers uses
+   one thread per core. Files longer than the thumbnail are summarized as
+   \c aggregation says, the mean by default.
+*/
+
+/*!
+  Constructs the options for \a width x \a height thumbnails along a curve of
+  \a type, with two readers and a queue of sixteen files.
+*/
+ThumbnailLoader::Options::Options(hsize width, hsize height, HilbertCurve::CurveType type):
+    width(width), height(height), type(type), format(PlainText), sampleType(BinaryLoader::Float64),
+    byteOrder(BinaryLoader::LittleEndian), readers(2), queueCapacity(16), workers(0),
+    aggregation(HilbertPlot::Mean)
+{
+}
+
+/*!
+  Returns the thumbnails of the files in \a paths, in the same order, rendered
+  as described by \a options with the curve taken from \a cache.
+
+  A file that can't be read or decoded doesn't stop the others: its
+  thumbnail has an empty image and keeps the exception in \c error.
+
+  Throws HilbertBadSize if the thumbnail size is zero.
+*/
+std::vector<ThumbnailLoader::Thumbnail> ThumbnailLoader::load(const std::vector<std::string> &paths,
+                                                              const Options &options, CurveCache &cache)
+{
+    if(options.width == 0 || options.height == 0)
+        throw HilbertBadSize();
+
+    std::vector<Thumbnail> thumbnails(paths.size ());
+    for(std::size_t i = 0; i < paths.size (); ++i)
+    {
+        thumbnails[i].path = paths[i];
+        thumbnails[i].values = 0;
+        thumbnails[i].timing = Timing{0, 0, 0};
+    }
+    if(paths.empty ())
+        return thumbnails;
+
+    CurveCache::CurvePointer curve = cache.curve (options.width, options.height, options.type);
+
+    unsigned int hardware_threads = std::thread::hardware_concurrency ();
+    unsigned int workers = options.workers > 0 ? options.workers : std::max(hardware_threads, 1u);
+    unsigned int readers = static_cast<unsigned int>(std::min<std::size_t>(std::max(options.readers, 1u), paths.size ()));
+    bounded_queue<FileContent> queue(options.queueCapacity);
+    std::atomic<std::size_t> next(0);
+    std::atomic<unsigned int> running(readers);
+
+    auto reader = [&]()
+    {
+        for(std::size_t id = next++; id < paths.size (); id = next++)
+        {
+            Clock::time_point start = Clock::now ();
+            try
+            {
+                FileContent content{id, readFile (paths[id])};
+                thumbnails[id].timing.read = seconds (start);
+                if(!queue.push (std::move(content)))
+                    break;
+            }
+            catch (...)
+            {
+                thumbnails[id].timing.read = seconds (start);
+                thumbnails[id].error = std::current_exception();
+            }
+        }
+        if(--running == 0)
+            queue.close ();
+    };
+
+    auto worker = [&]()
+    {
+        FileContent content;
+        while(queue.pop (content))
+        {
+            Thumbnail &thumbnail = thumbnails[content.id];
+            try
+            {
+                Clock::time_point start = Clock::now ();
+                const char *first = content.data.data ();
+                DataView values;
+                if(options.format == Raw)
+                    values = BinaryLoader::fromRaw (first, content.data.size (), options.sampleType, options.byteOrder);
+                else
+                    values = DataView::fromSequence (DataSequence::fromPlainText (first, first + content.data.size ()));
+                thumbnail.timing.parse = seconds (start);
+                thumbnail.values = values.size ();
+
+                start = Clock::now ();
+                thumbnail.image = render (values, *curve, options.aggregation);
+                thumbnail.timing.render = seconds (start);
+            }
+            catch (std::bad_alloc& ba)
+            {
+                thumbnail.error = std::make_exception_ptr(HilbertBadAlloc());
+            }
+            catch (...)
+            {
+                thumbnail.error = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::future<void>> futures;
+    for(unsigned int r = 0; r < readers; ++r)
+        futures.push_back (std::async(std::launch::async, reader));
+    for(unsigned int w = 0; w < workers; ++w)
+        futures.push_back (std::async(std::launch::async, worker));
+    for(auto &future : futures)
+        future.get ();
+    return thumbnails;
+}
+/*!
+  Returns the image of \a values plotted along \a curve, indexed as
+  image[x][y] and normalized to [0, 1].
+
+  If there are more values than curve points, each point summarizes a block
+  of consecutive values as given by \a aggregation, like
+  HilbertPlot::aggregate(); missing values are zero.
+*/
+HImage ThumbnailLoader::render(const DataView &values, const HilbertCurve &curve,
+                               HilbertPlot::AggregationMode aggregation)
+{
+    std::size_t cells = curve.lenght ();
+    DataSequence cellValues = HilbertPlot::aggregate (values, cells, aggregation);
+    cellValues.resize (cells, 0.0);
+
+    hfloat min = 0.0, max = 0.0;
+    if(cells > 0)
+    {
+        auto range = std::minmax_element (cellValues.begin (), cellValues.end ());
+        min = *range.first;
+        max = *range.second;
+    }
+    hfloat scale = max == min ? 0.0 : 1.0 / (max - min);
+
+    HImage image(curve.width (), std::vector<hfloat>(curve.height (), 0));
+    for(std::size_t i = 0; i < cells; ++i)
+    {
+        const HPoint &point = curve[i];
+        image[point.X ()][point.Y ()] = (cellValues[i] - min) * scale;
+    }
+    return image;
+}
+/*!
+  Returns the images of \a thumbnails tiled left to right and top to bottom
+  in rows of \a columns, separated by \a spacing cells. Cells without a
+  thumbnail, including those of failed files, are filled with \a background.
+
+  Throws HilbertBadSize if \a columns is zero.
+*/
+HImage ThumbnailLoader::mosaic(const std::vector<Thumbnail> &thumbnails, hsize columns, hsize spacing,
+                               hfloat background)
+{
+    if(columns == 0)
+        throw HilbertBadSize();
+    if(thumbnails.empty ())
+        return HImage();
+
+    hsize tileWidth = 0, tileHeight = 0;
+    for(const Thumbnail &thumbnail : thumbnails)
+    {
+        if(thumbnail.image.empty ())
+            continue;
+        tileWidth = std::max<hsize>(tileWidth, thumbnail.image.size ());
+        tileHeight = std::max<hsize>(tileHeight, thumbnail.image.front ().size ());
+    }
+    columns = std::min<hsize>(columns, thumbnails.size ());
+    hsize rows = (thumbnails.size () + columns - 1) / columns;
+    hsize width = columns * (tileWidth + spacing) - spacing;
+    hsize height = rows * (tileHeight + spacing) - spacing;
+
+    HImage image(width, std::vector<hfloat>(height, background));
+    for(std::size_t i = 0; i < thumbnails.size (); ++i)
+    {
+        const HImage &tile = thumbnails[i].image;
+        hsize left = (i % columns) * (tileWidth + spacing);
+        hsize top = (i / columns) * (tileHeight + spacing);
+        for(std::size_t x = 0; x < tile.size (); ++x)
+            std::copy (tile[x].begin (), tile[x].end (), image[left + x].begin () + top);
+    }
+    return image;
+}